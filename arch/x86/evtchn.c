@@ -0,0 +1,94 @@
+/**
+ * @file arch/x86/evtchn.c
+ *
+ * %x86 specific bits of event channel upcall handling.
+ *
+ * PV guests register an event callback, and control upcalls with
+ * vcpu_info.evtchn_upcall_mask.  HVM guests have Xen inject
+ * #X86_VEC_EVTCHN, and control upcalls with EFLAGS.IF.
+ */
+#include <xtf/barrier.h>
+#include <xtf/evtchn.h>
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+#include <xtf/smp.h>
+
+#include <arch/idt.h>
+#include <arch/segment.h>
+#include <arch/traps.h>
+
+#include <xen/hvm/params.h>
+
+void entry_EVTCHN(void);
+
+int arch_evtchn_init_upcall(void)
+{
+    if ( IS_DEFINED(CONFIG_PV) )
+    {
+        xen_callback_register_t cb = {
+            .type = CALLBACKTYPE_event,
+            .address = INIT_XEN_CALLBACK(__KERN_CS, _u(entry_EVTCHN)),
+        };
+
+        return hypercall_register_callback(&cb);
+    }
+    else /* HVM */
+    {
+        struct xtf_idte idte = {
+            .addr = _u(entry_EVTCHN),
+            .cs = __KERN_CS,
+        };
+        int rc = xtf_set_idte(X86_VEC_EVTCHN, &idte);
+
+        /* Without the gate, the first event would be an unhandled vector. */
+        if ( rc )
+            return rc;
+
+        return hvm_set_param(HVM_PARAM_CALLBACK_IRQ,
+                             ((uint64_t)HVM_PARAM_CALLBACK_TYPE_VECTOR <<
+                              HVM_PARAM_CALLBACK_IRQ_TYPE_SHIFT) |
+                             X86_VEC_EVTCHN);
+    }
+}
+
+void xtf_evtchn_upcalls_enable(void)
+{
+    if ( IS_DEFINED(CONFIG_PV) )
+    {
+        struct vcpu_info *vi = &shared_info.vcpu_info[smp_processor_id()];
+
+        ACCESS_ONCE(vi->evtchn_upcall_mask) = 0;
+
+        /*
+         * An event which arrived while masked doesn't cause an upcall.  Any
+         * hypercall will deliver it on return to guest context.
+         */
+        smp_mb();
+        if ( ACCESS_ONCE(vi->evtchn_upcall_pending) )
+            hypercall_xen_version(XENVER_version, NULL);
+    }
+    else
+        asm volatile ("sti" ::: "memory");
+}
+
+void xtf_evtchn_upcalls_disable(void)
+{
+    if ( IS_DEFINED(CONFIG_PV) )
+    {
+        ACCESS_ONCE(shared_info.vcpu_info[smp_processor_id()]
+                    .evtchn_upcall_mask) = 1;
+        barrier();
+    }
+    else
+        asm volatile ("cli" ::: "memory");
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
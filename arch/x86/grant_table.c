@@ -10,14 +10,17 @@
 #include <arch/pagetable.h>
 #include <arch/symbolic-const.h>
 
-int arch_map_gnttab(void)
+int arch_map_gnttab(unsigned int nr_frames)
 {
-    unsigned int i, nr_frames = sizeof(gnttab_raw) / PAGE_SIZE;
+    unsigned int i;
     int rc = 0;
 
     /* Ensure gnttab_raw[] is a whole number of pages. */
     BUILD_BUG_ON(sizeof(gnttab_raw) % PAGE_SIZE);
 
+    if ( nr_frames > sizeof(gnttab_raw) / PAGE_SIZE )
+        return -E2BIG;
+
     if ( IS_DEFINED(CONFIG_PV) )
     {
         unsigned long gnttab_gfns[nr_frames];
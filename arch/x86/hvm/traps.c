@@ -70,6 +70,9 @@ static env_tss tss_DF __aligned(16) =
     .iopb = X86_TSS_INVALID_IO_BITMAP,
 };
 
+/* TSSs for secondary vCPUs, filled in when they are brought up. */
+static env_tss ap_tss[XTF_MAX_CPUS - 1] __aligned(16);
+
 static void setup_gate(unsigned int entry, void *addr, unsigned int dpl)
 {
     pack_gate(&idt[entry], 14, __KERN_CS, _u(addr), dpl, 0);
@@ -154,6 +157,33 @@ void arch_init_traps(void)
     }
 }
 
+void arch_init_traps_ap(unsigned int cpu)
+{
+    env_tss *t = &ap_tss[cpu - 1];
+    uint8_t *stack = cpu_stack(cpu);
+
+#if defined(__i386__)
+    t->esp0 = _u(&stack[2 * PAGE_SIZE]);
+    t->ss0  = __KERN_DS;
+    t->cr3  = _u(cr3_target);
+#elif defined(__x86_64__)
+    t->rsp0   = _u(&stack[2 * PAGE_SIZE]);
+    t->ist[0] = _u(&stack[3 * PAGE_SIZE]);
+#endif
+    t->iopb = X86_TSS_INVALID_IO_BITMAP;
+
+    /*
+     * The IDT is shared.  For 32bit environments, this includes the @#DF
+     * task gate, so a double fault on any vCPU uses tss_DF and the emergency
+     * page of boot_stack[].
+     */
+    lidt(&idt_ptr);
+
+    gdt[GDTE_AP_TSS(cpu)] = GDTE(_u(t), 0x67, 0x89);
+    barrier();
+    ltr(GDTE_AP_TSS(cpu) * 8);
+}
+
 void __noreturn arch_crash_hard(void)
 {
     /*
@@ -29,6 +29,9 @@
 #define smp_rmb() barrier()
 #define smp_wmb() barrier()
 
+/* Spin-wait hint. */
+#define cpu_relax() __asm__ __volatile__ ("pause" ::: "memory")
+
 #endif /* XTF_X86_BARRIER_H */
 
 /*
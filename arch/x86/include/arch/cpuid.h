@@ -85,6 +85,7 @@ static inline bool cpu_has(unsigned int feature)
 #define cpu_has_nx              cpu_has(X86_FEATURE_NX)
 #define cpu_has_page1gb         cpu_has(X86_FEATURE_PAGE1GB)
 #define cpu_has_lm              cpu_has(X86_FEATURE_LM)
+#define cpu_has_rdtscp          cpu_has(X86_FEATURE_RDTSCP)
 
 #define cpu_has_svm             cpu_has(X86_FEATURE_SVM)
 
@@ -19,6 +19,11 @@
  */
 #define X86_VEC_AVAIL    0x21
 
+/**
+ * Event channel upcalls, for HVM guests.
+ */
+#define X86_VEC_EVTCHN   0x22
+
 
 #ifndef __ASSEMBLY__
 
@@ -374,6 +374,53 @@ static inline void write_xcr0(uint64_t xcr0)
     xsetbv(0, xcr0);
 }
 
+static inline uint64_t rdtsc(void)
+{
+    uint32_t lo, hi;
+
+    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint64_t rdtscp(uint32_t *aux)
+{
+    uint32_t lo, hi;
+
+    asm volatile ("rdtscp" : "=a" (lo), "=d" (hi), "=c" (*aux));
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+ * Read the TSC at the start of a timed region.  The leading lfence waits for
+ * all earlier instructions to complete, and the trailing lfence stops later
+ * instructions from starting before the TSC has been read.
+ */
+static inline uint64_t rdtsc_start(void)
+{
+    uint32_t lo, hi;
+
+    asm volatile ("lfence; rdtsc; lfence" : "=a" (lo), "=d" (hi) :: "memory");
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+ * Read the TSC at the end of a timed region.  rdtscp waits for all earlier
+ * instructions to complete, and the lfence stops later instructions from
+ * starting before the TSC has been read.  Requires cpu_has_rdtscp.
+ */
+static inline uint64_t rdtscp_end(void)
+{
+    uint32_t lo, hi, aux;
+
+    asm volatile ("rdtscp; lfence"
+                  : "=a" (lo), "=d" (hi), "=c" (aux) :: "memory");
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
 #endif /* XTF_X86_LIB_H */
 
 /*
@@ -1,6 +1,7 @@
 #ifndef XTF_X86_SEGMENT_H
 #define XTF_X86_SEGMENT_H
 
+#include <xtf/smp.h>
 #include <xtf/types.h>
 
 #include <xen/arch-x86/xen.h>
@@ -22,6 +23,8 @@
  *  8 - DF TSS (32bit only)
  *
  *  9-14 - Available for test use
+ *
+ *  15+  - TSS for secondary vCPUs (two slots each)
  */
 
 #define GDTE_CS64_DPL0 1
@@ -41,7 +44,9 @@
 #define GDTE_AVAIL4    13
 #define GDTE_AVAIL5    14
 
-#define NR_GDT_ENTRIES 15
+#define GDTE_AP_TSS(cpu) (15 + 2 * ((cpu) - 1))
+
+#define NR_GDT_ENTRIES GDTE_AP_TSS(XTF_MAX_CPUS)
 
 /*
  * HVM guests use the GDT directly.
@@ -2,6 +2,8 @@
 #define XTF_X86_TRAPS_H
 
 #include <xtf/compiler.h>
+#include <xtf/smp.h>
+
 #include <arch/regs.h>
 #include <arch/lib.h>
 #include <arch/page.h>
@@ -14,6 +16,12 @@
  */
 void arch_init_traps(void);
 
+/*
+ * Arch-specific function to initialise the exception handling of a secondary
+ * vCPU, when first brought up.
+ */
+void arch_init_traps_ap(unsigned int cpu);
+
 /*
  * Arch-specific function to quiesce the domain, in the event that a
  * shutdown(crash) hypercall has not succeeded.
@@ -53,8 +61,16 @@ static inline unsigned int cpu_regs_ss(const struct cpu_regs *regs)
 }
 
 extern uint8_t boot_stack[3 * PAGE_SIZE];
+extern uint8_t (*const ap_stacks)[3 * PAGE_SIZE];
+extern const unsigned int nr_ap_stacks;
 extern uint8_t user_stack[PAGE_SIZE];
 
+/* The stack of @p cpu, with the same layout as boot_stack[]. */
+static inline uint8_t *cpu_stack(unsigned int cpu)
+{
+    return cpu ? ap_stacks[cpu - 1] : boot_stack;
+}
+
 extern xen_pv_start_info_t *pv_start_info;
 extern xen_pvh_start_info_t *pvh_start_info;
 extern shared_info_t shared_info;
@@ -308,6 +308,15 @@ void arch_init_traps(void)
         panic("Failed to unmap page at NULL: %d\n", rc);
 }
 
+void arch_init_traps_ap(unsigned int cpu)
+{
+    /*
+     * The GDT, kernel stack and pagetables were provided in the initial vCPU
+     * context.  The trap table and callbacks are per-vCPU state.
+     */
+    init_callbacks();
+}
+
 void __noreturn arch_crash_hard(void)
 {
     /*
@@ -17,8 +17,15 @@
  * boot_stack[page 3] Emergency entrypoint
  * boot_stack[page 2] Exception entrypoints
  * boot_stack[page 1] Top of work stack
+ *
+ * Secondary vCPUs each have an ap_stacks[] entry with the same layout.
+ * There are none by default.  Tests which use secondary vCPUs provide
+ * stacks, and publish them via ap_stacks and nr_ap_stacks, with
+ * XTF_AP_STACKS().
  */
 uint8_t boot_stack[3 * PAGE_SIZE] __page_aligned_bss;
+uint8_t (*const __weak ap_stacks)[3 * PAGE_SIZE] = NULL;
+const unsigned int __weak nr_ap_stacks = 0;
 uint8_t user_stack[PAGE_SIZE] __user_page_aligned_bss;
 
 uint32_t x86_features[FSCAPINTS];
@@ -252,8 +259,6 @@ void arch_setup(void)
 
     collect_cpuid(IS_DEFINED(CONFIG_PV) ? pv_cpuid_count : cpuid_count);
 
-    sort_extable();
-
     arch_init_traps();
 
     init_hypercalls();
@@ -285,6 +290,8 @@ bool xtf_has_fep = false;
  * isn't worth running.
  */
 bool __weak test_wants_user_mappings = false;
+bool __weak test_wants_buffered_console = false;
+bool __weak test_wants_fail_fast = false;
 bool __weak test_needs_fep = false;
 
 void test_setup(void)
@@ -0,0 +1,231 @@
+/**
+ * @file arch/x86/smp.c
+ *
+ * Secondary vCPU bring-up.
+ *
+ * Both PV and HVM vCPUs are brought up with VCPUOP_initialise/VCPUOP_up,
+ * using a PV vcpu_guest_context or an HVM vcpu_hvm_context respectively, in
+ * the same paging mode as the boot vCPU.
+ */
+#include <xtf/atomic.h>
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+#include <xtf/smp.h>
+#include <xtf/traps.h>
+
+#include <arch/desc.h>
+#include <arch/mm.h>
+#include <arch/msr.h>
+#include <arch/processor.h>
+#include <arch/segment.h>
+
+void _ap_start(void);
+void __noreturn ap_main(void);
+
+static struct ap_state {
+    void (*fn)(void *);
+    void *arg;
+    bool initialised;
+    bool running;
+} aps[XTF_MAX_CPUS];
+
+unsigned int smp_processor_id(void)
+{
+    unsigned long sp;
+
+    asm ("mov %%" _ASM_SP ", %0" : "=r" (sp));
+
+    if ( sp >= _u(ap_stacks) && sp < _u(ap_stacks + nr_ap_stacks) )
+        return (sp - _u(ap_stacks)) / sizeof(ap_stacks[0]) + 1;
+
+    return 0;
+}
+
+unsigned int xtf_nr_cpus(void)
+{
+    static unsigned int nr;
+
+    /*
+     * VCPUOP_is_up fails with -ENOENT for vCPUs the domain doesn't have.
+     * Secondary vCPUs without a stack are of no use.
+     */
+    if ( !nr )
+        for ( nr = 1; nr < min(nr_ap_stacks + 1, XTF_MAX_CPUS + 0u); ++nr )
+            if ( hypercall_vcpu_op(VCPUOP_is_up, nr, NULL) < 0 )
+                break;
+
+    return nr;
+}
+
+#if defined(CONFIG_PV)
+
+static int initialise_vcpu(unsigned int cpu)
+{
+    /* Too large for the stack. */
+    static struct xen_vcpu_guest_context ctx;
+    uint8_t *stack = cpu_stack(cpu);
+
+    memset(&ctx, 0, sizeof(ctx));
+
+    ctx.flags = VGCF_in_kernel | VGCF_online;
+
+    ctx.user_regs.eip    = _u(_ap_start);
+    ctx.user_regs.esp    = _u(&stack[PAGE_SIZE]);
+    ctx.user_regs.eflags = X86_EFLAGS_MBS;
+    ctx.user_regs.cs     = __KERN_CS;
+    ctx.user_regs.ss     = __KERN_DS;
+    ctx.user_regs.ds     = __USER_DS;
+    ctx.user_regs.es     = __USER_DS;
+    ctx.user_regs.fs     = __USER_DS;
+    ctx.user_regs.gs     = __USER_DS;
+
+    /* gdt[] has already been remapped read-only by the boot vCPU. */
+    ctx.gdt_frames[0] = virt_to_mfn(gdt);
+    ctx.gdt_ents      = NR_GDT_ENTRIES;
+
+    ctx.kernel_ss = __KERN_DS;
+    ctx.kernel_sp = _u(&stack[2 * PAGE_SIZE]);
+
+    ctx.ctrlreg[3] = read_cr3();
+#ifdef __x86_64__
+    /* XTF uses a shared user/kernel address space. */
+    ctx.ctrlreg[1] = read_cr3();
+#else
+    ctx.event_callback_cs    = __KERN_CS;
+    ctx.failsafe_callback_cs = __KERN_CS;
+#endif
+
+    return hypercall_vcpu_op(VCPUOP_initialise, cpu, &ctx);
+}
+
+#else /* CONFIG_HVM */
+
+static int initialise_vcpu(unsigned int cpu)
+{
+    struct xen_vcpu_hvm_context ctx = {};
+    uint8_t *stack = cpu_stack(cpu);
+
+#ifdef __x86_64__
+    ctx.mode = VCPU_HVM_MODE_64B;
+    ctx.cpu_regs.x86_64 = (struct xen_vcpu_hvm_x86_64){
+        .rip    = _u(_ap_start),
+        .rsp    = _u(&stack[PAGE_SIZE]),
+        .rflags = X86_EFLAGS_MBS,
+
+        .cr0  = read_cr0(),
+        .cr3  = read_cr3(),
+        .cr4  = read_cr4(),
+        .efer = rdmsr(MSR_EFER),
+    };
+#else
+    ctx.mode = VCPU_HVM_MODE_32B;
+    ctx.cpu_regs.x86_32 = (struct xen_vcpu_hvm_x86_32){
+        .eip    = _u(_ap_start),
+        .esp    = _u(&stack[PAGE_SIZE]),
+        .eflags = X86_EFLAGS_MBS,
+
+        .cr0 = read_cr0(),
+        .cr3 = read_cr3(),
+        .cr4 = read_cr4(),
+
+        /* Flat 32bit segments.  _ap_start loads XTF's own GDT. */
+        .cs_limit = ~0u,
+        .ds_limit = ~0u,
+        .ss_limit = ~0u,
+        .es_limit = ~0u,
+        .tr_limit = 0x67,
+
+        .cs_ar = 0xc9b,
+        .ds_ar = 0xc93,
+        .ss_ar = 0xc93,
+        .es_ar = 0xc93,
+        .tr_ar = 0x8b,
+    };
+#endif
+
+    return hypercall_vcpu_op(VCPUOP_initialise, cpu, &ctx);
+}
+
+#endif /* CONFIG_PV / CONFIG_HVM */
+
+void __noreturn ap_main(void)
+{
+    unsigned int cpu = smp_processor_id();
+    struct ap_state *ap = &aps[cpu];
+
+    arch_init_traps_ap(cpu);
+
+    for ( ;; )
+    {
+        ap->fn(ap->arg);
+
+        STORE_RELEASE(&ap->running, false);
+
+        /*
+         * Go offline.  This is synchronous when issued by the vCPU itself.
+         * VCPUOP_up resumes execution here.
+         */
+        hypercall_vcpu_op(VCPUOP_down, cpu, NULL);
+    }
+}
+
+int xtf_start_cpu(unsigned int cpu, void (*fn)(void *), void *arg)
+{
+    struct ap_state *ap;
+    int rc = 0;
+
+    if ( cpu == 0 || cpu >= xtf_nr_cpus() )
+        return -EINVAL;
+
+    ap = &aps[cpu];
+
+    if ( LOAD_ACQUIRE(&ap->running) )
+        return -EBUSY;
+
+    /*
+     * A vCPU marks itself as not running before going offline.  Wait for it
+     * to actually be offline, or VCPUOP_up below would be lost.
+     */
+    while ( hypercall_vcpu_op(VCPUOP_is_up, cpu, NULL) > 0 )
+        hypercall_yield();
+
+    ap->fn = fn;
+    ap->arg = arg;
+    STORE_RELEASE(&ap->running, true);
+
+    if ( !ap->initialised )
+    {
+        rc = initialise_vcpu(cpu);
+        if ( rc == 0 )
+            ap->initialised = true;
+    }
+
+    if ( rc == 0 )
+        rc = hypercall_vcpu_op(VCPUOP_up, cpu, NULL);
+
+    if ( rc )
+        ap->running = false;
+
+    return rc;
+}
+
+bool xtf_cpu_running(unsigned int cpu)
+{
+    return cpu < XTF_MAX_CPUS && LOAD_ACQUIRE(&aps[cpu].running);
+}
+
+void xtf_wait_cpu(unsigned int cpu)
+{
+    while ( xtf_cpu_running(cpu) )
+        hypercall_yield();
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -73,6 +73,15 @@ void __weak do_syscall(struct cpu_regs *regs)
     panic("Unhandled syscall\n");
 }
 
+/*
+ * Overridden by common/evtchn.c, which is only linked into tests using
+ * upcalls.  The entry stub is always linked, but never registered otherwise.
+ */
+void __weak do_evtchn_upcall(struct cpu_regs *regs)
+{
+    panic("Unexpected event channel upcall\n");
+}
+
 /*
  * Local variables:
  * mode: C
@@ -1,4 +1,4 @@
-ALL_CATEGORIES     := special functional xsa utility in-development
+ALL_CATEGORIES     := special functional xsa utility in-development perf
 
 ALL_ENVIRONMENTS   := pv64 pv32pae hvm64 hvm32pae hvm32pse hvm32
 
@@ -17,9 +17,14 @@ $(foreach env,$(64BIT_ENVIRONMENTS),$(eval $(env)_arch := x86_64))
 
 COMMON_FLAGS := -pipe -I$(ROOT)/include -I$(ROOT)/arch/x86/include -MMD -MP
 
-# Experimental LTO support.  `make ... lto=y`
+# LTO support.  `make ... lto=y`
 COMMON_CFLAGS-$(lto) := -flto
-LDFLAGS-$(lto) := -flto -B /usr/lib/gold-ld
+LDFLAGS-$(lto) := -flto -fuse-linker-plugin
+AR-$(lto) := $(CROSS_COMPILE)gcc-ar
+
+# Minimal memory profile.  `make ... min_memory=y`
+# Size each test domain from its image's _end, rather than the default config.
+cfg-image-$(min_memory) = $(1)
 
 COMMON_AFLAGS := $(COMMON_FLAGS) -D__ASSEMBLY__
 COMMON_CFLAGS := $(COMMON_FLAGS) $(COMMON_CFLAGS-y)
@@ -27,6 +32,7 @@ COMMON_CFLAGS += -Wall -Wextra -Werror -std=gnu99 -Wstrict-prototypes -O3 -g
 COMMON_CFLAGS += -fno-common -fno-asynchronous-unwind-tables -fno-strict-aliasing
 COMMON_CFLAGS += -fno-stack-protector -fno-pic -ffreestanding
 COMMON_CFLAGS += -mno-red-zone -mno-sse
+COMMON_CFLAGS += -ffunction-sections -fdata-sections
 COMMON_CFLAGS += -Wno-unused-parameter -Winline
 
 COMMON_AFLAGS-x86_32 := -m32
@@ -42,6 +48,10 @@ obj-perarch :=
 obj-perenv  :=
 include $(ROOT)/build/files.mk
 
+# The framework's own objects, as opposed to those added by tests.
+lib-perarch := $(obj-perarch)
+lib-perenv  := $(obj-perenv)
+
 
 cc-option = $(shell if [ -z "`echo 'int p=1;' | $(CC) $(1) -S -o /dev/null -x c - 2>&1`" ]; \
 			then echo y; else echo n; fi)
@@ -61,12 +71,29 @@ CFLAGS_$(1) := $$(CFLAGS_$($(1)_arch)) $$(COMMON_CFLAGS-$(1)) -DCONFIG_ENV_$(1)
 head-$(1) := $(ROOT)/arch/x86/$($(1)_guest)/head-$(1).o
 link-$(1) := $(ROOT)/arch/x86/link-$(1).lds
 
-LDFLAGS_$(1) := -Wl,-T,$$(link-$(1)) -nostdlib $(LDFLAGS-y)
+LDFLAGS_$(1) := -Wl,-T,$$(link-$(1)) -Wl,--gc-sections -nostdlib $(LDFLAGS-y)
+
+# LTO generates code at link time, so needs the compile flags again.
+ifeq ($(lto),y)
+LDFLAGS_$(1) += $$(CFLAGS_$(1))
+endif
+
+# The framework, built once per environment and shared by all tests
+lib-$(1) := $(ROOT)/arch/x86/libxtf-$(1).a
+
+LIBOBJS-$(1) := $$(lib-perarch:%.o=%-$($(1)_arch).o) \
+	$$(obj-$(1):%.o=%-$(1).o) $$(lib-perenv:%.o=%-$(1).o)
 
 # Needs to pick up test-provided obj-perenv and obj-perarch
-DEPS-$(1) = $$(head-$(1)) \
-	$$(obj-perarch:%.o=%-$($(1)_arch).o) \
-	$$(obj-$(1):%.o=%-$(1).o) $$(obj-perenv:%.o=%-$(1).o)
+TESTOBJS-$(1) = \
+	$$(patsubst %.o,%-$($(1)_arch).o,$$(filter-out $$(lib-perarch),$$(obj-perarch))) \
+	$$(patsubst %.o,%-$(1).o,$$(filter-out $$(lib-perenv),$$(obj-perenv)))
+
+DEPS-$(1) = $$(head-$(1)) $$(TESTOBJS-$(1)) $$(lib-$(1))
+
+$$(lib-$(1)): $$(LIBOBJS-$(1))
+	rm -f $$@
+	$$(firstword $$(AR-y) $$(AR)) rcs $$@ $$^
 
 # Generate .lds with approprate flags
 %/link-$(1).lds: %/link.lds.S
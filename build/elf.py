@@ -0,0 +1,61 @@
+# -*- coding: utf-8 -*-
+
+"""
+Minimal ELF parsing for the build scripts, covering just enough of the
+section headers and symbol table to locate symbols in a linked test image.
+"""
+
+import struct
+
+def parse(data, path):
+    """
+    Return (word format, sections, symbols) of the ELF image 'data', read
+    from 'path'.
+
+    Sections are tuples of the Elf{32,64}_Shdr fields, in order.  Symbols are
+    a name (bytes) => st_value dict.
+    """
+
+    if data[:4] != b"\x7fELF":
+        raise ValueError("%s is not an ELF file" % (path, ))
+
+    if data[4:5] == b"\x02": # ELFCLASS64
+        shoff, = struct.unpack_from("<Q", data, 0x28)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x3a)
+        word, shdr, sym, symsize = "<Q", "<IIQQQQIIQQ", "<IBBHQQ", 24
+    else:
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2e)
+        word, shdr, sym, symsize = "<I", "<IIIIIIIIII", "<IIIBBH", 16
+
+    sections = [ struct.unpack_from(shdr, data, shoff + i * shentsize)
+                 for i in range(shnum) ]
+
+    symbols = {}
+    for sh in sections:
+        if sh[1] != 2: # SHT_SYMTAB
+            continue
+
+        strtab = sections[sh[6]]
+        for off in range(sh[4], sh[4] + sh[5], symsize):
+            ent = struct.unpack_from(sym, data, off)
+            name_off = strtab[4] + ent[0]
+            name = data[name_off:data.index(b"\0", name_off)]
+
+            # st_value is the 2nd field of Elf32_Sym, 5th of Elf64_Sym.
+            symbols[name] = ent[4] if symsize == 24 else ent[1]
+
+    return word, sections, symbols
+
+def file_offset(sections, addr, path):
+    """ Translate virtual address 'addr' to an offset in the file """
+
+    for sh in sections:
+        # sh_type != SHT_NOBITS, sh_flags & SHF_ALLOC, addr in [addr, +size).
+        # Half open, as an address at one section's end may be the start of
+        # the next.
+        if (sh[1] != 8 and sh[2] & 2 and
+            sh[3] <= addr < sh[3] + sh[5]):
+            return sh[4] + addr - sh[3]
+
+    raise ValueError("Address %#x not in any section of %s" % (addr, path))
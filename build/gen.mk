@@ -32,7 +32,7 @@ build: $(foreach env,$(TEST-ENVS),test-$(env)-$(NAME)) $(TEST-CFGS)
 build: info.json
 
 info.json: $(ROOT)/build/mkinfo.py FORCE
-	@$(PYTHON) $< $@.tmp "$(NAME)" "$(CATEGORY)" "$(TEST-ENVS)" "$(VARY-CFG)"
+	@$(PYTHON) $< $@.tmp "$(NAME)" "$(CATEGORY)" "$(TEST-ENVS)" "$(VARY-CFG)" "$(TEST-TIMEOUT)"
 	@$(call move-if-changed,$@.tmp,$@)
 
 .PHONY: install install-each-env
@@ -44,36 +44,42 @@ hvm64-format := $(firstword $(filter elf32-x86-64,$(shell $(OBJCOPY) --help)) el
 
 define PERENV_build
 
+# The exception table is sorted after linking, rather than on every boot.
 ifneq ($(1),hvm64)
 # Generic link line for most environments
-test-$(1)-$(NAME): $$(DEPS-$(1)) $$(link-$(1))
-	$(CC) $$(LDFLAGS_$(1)) $$(DEPS-$(1)) -o $$@
+test-$(1)-$(NAME): $$(DEPS-$(1)) $$(link-$(1)) $(ROOT)/build/sortextable.py $(ROOT)/build/elf.py
+	$(CC) $$(LDFLAGS_$(1)) $$(DEPS-$(1)) -o $$@.tmp
+	$(PYTHON) $(ROOT)/build/sortextable.py $$@.tmp
+	mv $$@.tmp $$@
 else
 # hvm64 needs linking normally, then converting to elf32-x86-64 or elf32-i386
-test-$(1)-$(NAME): $$(DEPS-$(1)) $$(link-$(1))
+test-$(1)-$(NAME): $$(DEPS-$(1)) $$(link-$(1)) $(ROOT)/build/sortextable.py $(ROOT)/build/elf.py
 	$(CC) $$(LDFLAGS_$(1)) $$(DEPS-$(1)) -o $$@.tmp
+	$(PYTHON) $(ROOT)/build/sortextable.py $$@.tmp
 	$(OBJCOPY) $$@.tmp -O $(hvm64-format) $$@
 	rm -f $$@.tmp
 endif
 
 cfg-$(1) ?= $(defcfg-$($(1)_guest))
 
-cfg-default-deps := $(ROOT)/build/mkcfg.py $$(cfg-$(1)) $(TEST-EXTRA-CFG) FORCE
+cfg-default-deps := $(ROOT)/build/mkcfg.py $(ROOT)/build/elf.py $$(cfg-$(1))
+cfg-default-deps += $(TEST-EXTRA-CFG) FORCE
+cfg-default-deps += $$(call cfg-image-y,test-$(1)-$(NAME))
 
 test-$(1)-$(NAME).cfg: $$(cfg-default-deps)
-	$(PYTHON) $$< $$@.tmp "$$(cfg-$(1))" "$(TEST-EXTRA-CFG)" ""
+	$(PYTHON) $$< $$@.tmp "$$(cfg-$(1))" "$(TEST-EXTRA-CFG)" "" $$(call cfg-image-y,test-$(1)-$(NAME))
 	@$(call move-if-changed,$$@.tmp,$$@)
 
 test-$(1)-$(NAME)~%.cfg: $$(cfg-default-deps) %.cfg.in
-	$(PYTHON) $$< $$@.tmp "$$(cfg-$(1))" "$(TEST-EXTRA-CFG)" "$$*.cfg.in"
+	$(PYTHON) $$< $$@.tmp "$$(cfg-$(1))" "$(TEST-EXTRA-CFG)" "$$*.cfg.in" $$(call cfg-image-y,test-$(1)-$(NAME))
 	@$(call move-if-changed,$$@.tmp,$$@)
 
 test-$(1)-$(NAME)~%.cfg: $$(cfg-default-deps) $(ROOT)/config/%.cfg.in
-	$(PYTHON) $$< $$@.tmp "$$(cfg-$(1))" "$(TEST-EXTRA-CFG)" "$(ROOT)/config/$$*.cfg.in"
+	$(PYTHON) $$< $$@.tmp "$$(cfg-$(1))" "$(TEST-EXTRA-CFG)" "$(ROOT)/config/$$*.cfg.in" $$(call cfg-image-y,test-$(1)-$(NAME))
 	@$(call move-if-changed,$$@.tmp,$$@)
 
 -include $$(link-$(1):%.lds=%.d)
--include $$(DEPS-$(1):%.o=%.d)
+-include $$(patsubst %.o,%.d,$$(head-$(1)) $$(TESTOBJS-$(1)) $$(LIBOBJS-$(1)))
 
 .PHONY: install-$(1) install-$(1).cfg
 install-$(1): test-$(1)-$(NAME)
@@ -91,7 +97,7 @@ $(foreach env,$(TEST-ENVS),$(eval $(call PERENV_build,$(env))))
 
 .PHONY: clean
 clean:
-	find $(ROOT) \( -name "*.o" -o -name "*.d" \) -delete
+	find $(ROOT) \( -name "*.o" -o -name "*.d" -o -name "*.a" \) -delete
 	rm -f $(foreach env,$(TEST-ENVS),test-$(env)-$(NAME) test-$(env)-$(NAME)*.cfg)
 
 .PHONY: %var
@@ -0,0 +1,10 @@
+# Build the framework for every environment, ahead of the tests linking
+# against it.
+
+include $(ROOT)/build/common.mk
+
+.PHONY: lib
+lib: $(foreach env,$(ALL_ENVIRONMENTS),$(head-$(env)) $(link-$(env)) $(lib-$(env)))
+
+-include $(foreach env,$(ALL_ENVIRONMENTS),$(link-$(env):%.lds=%.d))
+-include $(foreach env,$(ALL_ENVIRONMENTS),$(patsubst %.o,%.d,$(head-$(env)) $(LIBOBJS-$(env))))
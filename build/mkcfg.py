@@ -6,10 +6,25 @@
 substitue variables appropriately.
 """
 
-import sys, os
+import sys, os, re
 
-# Usage: mkcfg.py $OUT $DEFAULT-CFG $EXTRA-CFG $VARY-CFG
-_, out, defcfg, extracfg, varycfg = sys.argv
+# Don't leave compiled helper modules in the source tree.
+sys.dont_write_bytecode = True
+import elf
+
+# Usage: mkcfg.py $OUT $DEFAULT-CFG $EXTRA-CFG $VARY-CFG [$IMAGE]
+#
+# If $IMAGE is given, the memory= and shadow_memory= settings of $DEFAULT-CFG
+# are replaced with the smallest viable sizes for the image.
+_, out, defcfg, extracfg, varycfg = sys.argv[:5]
+image = (sys.argv[5:] or [""])[0]
+
+MB = 1 << 20
+
+# Memory needed beyond the end of the image (MB).  PV guests need room for
+# the start_info page, console and xenstore rings, p2m and the initial
+# pagetables which the domain builder places after the kernel.
+headroom = { "pv": 4, "hvm": 2 }
 
 # Evaluate environment and name from $OUT
 _, env, name = out.split('.')[0].split('-', 2)
@@ -29,15 +44,63 @@ def expand(text):
             .replace("@@VARIATION@@", variation)
         )
 
+def elf_symbol(path, symbol):
+    """ Look up the value of 'symbol' in the ELF file at 'path' """
+
+    _, _, symbols = elf.parse(open(path, "rb").read(), path)
+
+    try:
+        return symbols[symbol.encode()]
+    except KeyError:
+        raise ValueError("%s not found in %s" % (symbol, path))
+
+def min_memory(config, full):
+    """Replace the memory settings in 'config' with the minimum for image.
+
+    'full' is the complete configuration, for the number of vcpus.
+    """
+
+    guest = "pv" if env.startswith("pv") else "hvm"
+
+    # The image is linked at its load address, so _end covers everything
+    # from 0 up to the end of .bss.
+    end = elf_symbol(image, "_end")
+    memory = (end + MB - 1) // MB + headroom[guest]
+
+    config = re.sub(r"(?m)^memory=.*$", "memory=%d" % (memory, ), config)
+
+    if guest == "hvm":
+        # As libxl_get_required_shadow_memory(): 4 * (256 * vcpus +
+        # 2 * memory_mb) kB, rounded up to whole MB.  Never go below the
+        # setting in the default configuration, which may deliberately be
+        # larger than libxl's estimate.
+        m = re.search(r"(?m)^vcpus\s*=\s*(\d+)", full)
+        vcpus = int(m.group(1)) if m else 1
+        shadow = (4 * (256 * vcpus + 2 * memory) + 1023) // 1024
+
+        m = re.search(r"(?m)^shadow_memory=(\d+)", config)
+        if m:
+            shadow = max(shadow, int(m.group(1)))
+
+        config = re.sub(r"(?m)^shadow_memory=.*$",
+                        "shadow_memory=%d" % (shadow, ), config)
+
+    return config
+
 config = open(defcfg).read()
+extra = extracfg and open(extracfg).read() or ""
+vary = varycfg and open(varycfg).read() or ""
+
+if image:
+    config = min_memory(config, config + extra + vary)
 
 if extracfg:
     config += "\n# Test Extra Configuration:\n"
-    config += open(extracfg).read()
+    config += extra
 
 if varycfg:
     config += "\n# Test Variation Configuration:\n"
-    config += open(varycfg).read()
+    config += vary
 
 cfg = expand(config)
 
@@ -3,8 +3,11 @@
 
 import sys, os, json
 
-# Usage: mkcfg.py $OUT $NAME $CATEGORY $ENVS $VARIATIONS
-_, out, name, cat, envs, variations = sys.argv
+# Usage: mkcfg.py $OUT $NAME $CATEGORY $ENVS $VARIATIONS [$TIMEOUT]
+_, out, name, cat, envs, variations = sys.argv[:6]
+timeout = ""
+if len(sys.argv) > 6:
+    timeout = sys.argv[6]
 
 template = {
     "name": name,
@@ -17,6 +20,8 @@
     template["environments"] = envs.split(" ")
 if variations:
     template["variations"] = variations.split(" ")
+if timeout:
+    template["timeout"] = int(timeout)
 
 open(out, "w").write(
     json.dumps(template, indent=4, separators=(',', ': '))
@@ -0,0 +1,105 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+"""
+Sort the exception table of a linked test image in place, so it is ready
+for search_extable() to bisect without being sorted on every boot.
+
+The table is located by its __start_ex_table and __stop_ex_table symbols,
+and is an array of struct extable_entry, each three native words of which
+the first (fault) is the sort key.  The result is verified by re-parsing the
+written image, locating the table afresh from its symbols, and checking that
+it is strictly ascending.  Duplicate fault addresses are rejected, as only
+one entry could ever be found.
+"""
+
+import sys, struct
+
+# Don't leave compiled helper modules in the source tree.
+sys.dont_write_bytecode = True
+import elf
+
+# Usage: sortextable.py $IMAGE
+_, image = sys.argv
+
+def read_table(data, word, offset, nr):
+    """ Read 'nr' (fault, fixup, handler) entries at 'offset' """
+
+    fmt = "<" + word[1] * 3
+    size = struct.calcsize(fmt)
+
+    return [ struct.unpack_from(fmt, data, offset + i * size)
+             for i in range(nr) ]
+
+def locate_table(data):
+    """ Return (word format, offset, nr entries) of the table in 'data' """
+
+    word, sections, symbols = elf.parse(data, image)
+
+    try:
+        start = symbols[b"__start_ex_table"]
+        stop = symbols[b"__stop_ex_table"]
+    except KeyError:
+        raise ValueError("No exception table in %s" % (image, ))
+
+    entsize = 3 * struct.calcsize(word)
+    if stop < start or (stop - start) % entsize:
+        raise ValueError("Malformed exception table in %s: %#x-%#x"
+                         % (image, start, stop))
+
+    nr = (stop - start) // entsize
+    if nr == 0:
+        return word, 0, 0
+
+    return word, elf.file_offset(sections, start, image), nr
+
+def main():
+    """ Main entrypoint """
+
+    data = bytearray(open(image, "rb").read())
+    word, offset, nr = locate_table(bytes(data))
+    if nr == 0:
+        return 0
+
+    entsize = 3 * struct.calcsize(word)
+    table = read_table(data, word, offset, nr)
+    table.sort(key = lambda e: e[0])
+
+    for prev, cur in zip(table, table[1:]):
+        if prev[0] == cur[0]:
+            raise ValueError("Duplicate exception table entries for %#x "
+                             "in %s" % (cur[0], image))
+
+    fmt = "<" + word[1] * 3
+    for i, ent in enumerate(table):
+        struct.pack_into(fmt, data, offset + i * entsize, *ent)
+
+    f = open(image, "r+b")
+    try:
+        f.write(data)
+    finally:
+        f.close()
+
+    # Verify the result, as search_extable() will silently miss entries if
+    # the table isn't sorted.  Locate the table afresh in the written image,
+    # so a wrong offset above can't go unnoticed.
+    data = open(image, "rb").read()
+    word, offset, check_nr = locate_table(data)
+    check = read_table(data, word, offset, check_nr)
+
+    if check_nr != nr:
+        raise ValueError("Exception table of %s changed size" % (image, ))
+
+    for prev, cur in zip(check, check[1:]):
+        if prev[0] >= cur[0]:
+            raise ValueError("Exception table of %s not sorted at %#x"
+                             % (image, cur[0]))
+
+    return 0
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except ValueError:
+        sys.stderr.write("sortextable.py: %s\n" % (sys.exc_info()[1], ))
+        sys.exit(1)
@@ -0,0 +1,371 @@
+/**
+ * @file common/bench.c
+ *
+ * Microbenchmark harness.
+ */
+#include <xtf/atomic.h>
+#include <xtf/barrier.h>
+#include <xtf/bench.h>
+#include <xtf/lib.h>
+#include <xtf/report.h>
+#include <xtf/smp.h>
+#include <xtf/traps.h>
+
+#include <arch/div.h>
+
+static uint64_t bench_samples[XTF_BENCH_MAX_SAMPLES];
+static uint64_t stress_samples[XTF_MAX_CPUS][XTF_BENCH_STRESS_MAX_SAMPLES];
+
+/* State shared between vCPUs for the stress benchmark in progress. */
+static struct {
+    void (*fn)(void);
+    unsigned int iterations;
+    unsigned int ready;
+    bool go;
+} stress;
+
+/* Cost of an empty timing bracket, subtracted from every sample. */
+static uint64_t overhead;
+static bool overhead_valid;
+
+static unsigned long tsc_khz;
+static bool tsc_khz_valid;
+
+static unsigned long calibrate_tsc_khz(void)
+{
+    const struct vcpu_time_info *t = &shared_info.vcpu_info[0].time;
+    uint32_t version, mul, eax, ebx, ecx, edx;
+    int8_t shift;
+
+    /* Read a consistent copy of Xen's TSC scale. */
+    do {
+        version = ACCESS_ONCE(t->version);
+        smp_rmb();
+        mul = t->tsc_to_system_mul;
+        shift = t->tsc_shift;
+        smp_rmb();
+    } while ( (version & 1) || (version != ACCESS_ONCE(t->version)) );
+
+    if ( mul )
+    {
+        /* kHz = ((10^6 << 32) / tsc_to_system_mul) >> tsc_shift */
+        uint64_t khz = 1000000ull << 32;
+
+        divmod64(&khz, mul);
+
+        return shift < 0 ? khz << -shift : khz >> shift;
+    }
+
+    /* Leaf 0x15: Crystal frequency, and TSC/crystal ratio. */
+    if ( max_leaf >= 0x15 )
+    {
+        cpuid_count(0x15, 0, &eax, &ebx, &ecx, &edx);
+
+        if ( eax && ebx && ecx )
+        {
+            uint64_t hz = (uint64_t)ecx * ebx;
+
+            divmod64(&hz, eax);
+            divmod64(&hz, 1000);
+
+            return hz;
+        }
+    }
+
+    /* Leaf 0x16: Processor base frequency in MHz. */
+    if ( max_leaf >= 0x16 )
+    {
+        cpuid_count(0x16, 0, &eax, &ebx, &ecx, &edx);
+
+        if ( eax & 0xffff )
+            return (eax & 0xffff) * 1000ul;
+    }
+
+    return 0;
+}
+
+unsigned long xtf_tsc_khz(void)
+{
+    if ( !tsc_khz_valid )
+    {
+        tsc_khz = calibrate_tsc_khz();
+        tsc_khz_valid = true;
+    }
+
+    return tsc_khz;
+}
+
+static int compare_sample(const void *_l, const void *_r)
+{
+    const uint64_t *l = _l, *r = _r;
+
+    if ( *l == *r )
+        return 0;
+    else if ( *l > *r )
+        return 1;
+    else
+        return -1;
+}
+
+static void swap_sample(void *_l, void *_r)
+{
+    uint64_t tmp, *l = _l, *r = _r;
+
+    tmp = *l;
+    *l = *r;
+    *r = tmp;
+}
+
+void xtf_bench_summarise(uint64_t *samples, unsigned int nr,
+                         struct xtf_bench_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    if ( nr == 0 )
+        return;
+
+    heapsort(samples, nr, sizeof(*samples), compare_sample, swap_sample);
+
+    stats->nr     = nr;
+    stats->min    = samples[0];
+    stats->median = samples[nr / 2];
+    stats->p99    = samples[(nr - 1) * 99 / 100];
+    stats->max    = samples[nr - 1];
+}
+
+void xtf_bench_report(const char *name, const struct xtf_bench_stats *stats)
+{
+    printk("BENCH name=%s iters=%u min=%"PRIu64" median=%"PRIu64
+           " p99=%"PRIu64" max=%"PRIu64" overhead=%"PRIu64" tsc_khz=%lu\n",
+           name, stats->nr, stats->min, stats->median, stats->p99,
+           stats->max, overhead, xtf_tsc_khz());
+
+    xtf_report_metric(name, "iters=%u min=%"PRIu64" median=%"PRIu64
+                      " p99=%"PRIu64" max=%"PRIu64, stats->nr, stats->min,
+                      stats->median, stats->p99, stats->max);
+}
+
+void xtf_bench_report_rate(const char *name, const char *unit, unsigned int nr,
+                           const struct xtf_bench_stats *stats)
+{
+    unsigned long khz = xtf_tsc_khz();
+    uint64_t each = stats->median, per_sec = 0;
+    char metric[64];
+
+    if ( nr )
+        divmod64(&each, nr);
+
+    /* per_sec = nr * (khz * 1000) / median cycles. */
+    if ( khz && stats->median && stats->median <= UINT32_MAX )
+    {
+        per_sec = (uint64_t)nr * khz * 1000;
+        divmod64(&per_sec, stats->median);
+    }
+
+    printk("RATE name=%s %s=%u cycles_each=%"PRIu64" per_sec=%"PRIu64"\n",
+           name, unit, nr, each, per_sec);
+
+    snprintf(metric, sizeof(metric), "%s/rate", name);
+    xtf_report_metric(metric, "%s=%u cycles_each=%"PRIu64" per_sec=%"PRIu64,
+                      unit, nr, each, per_sec);
+}
+
+static void __noinline empty_fn(void)
+{
+}
+
+/*
+ * Time @p nr calls to @p fn into bench_samples[], after a number of untimed
+ * warm-up calls.  Samples are not adjusted for overhead.
+ */
+static void collect_samples(void (*fn)(void), unsigned int nr)
+{
+    unsigned int i;
+    uint64_t start;
+
+    for ( i = 0; i < XTF_BENCH_WARMUP; ++i )
+        fn();
+
+    for ( i = 0; i < nr; ++i )
+    {
+        start = xtf_bench_start();
+        fn();
+        bench_samples[i] = xtf_bench_end() - start;
+    }
+
+    xtf_heartbeat();
+}
+
+/*
+ * Measure the cost of the timing bracket around an (out of line) empty
+ * function.  The minimum is used, as it is the most repeatable.
+ */
+static void calibrate_overhead(void)
+{
+    unsigned int i;
+
+    collect_samples(empty_fn, 256);
+
+    overhead = bench_samples[0];
+    for ( i = 1; i < 256; ++i )
+        overhead = min(overhead, bench_samples[i]);
+
+    overhead_valid = true;
+}
+
+static void subtract_overhead(uint64_t *samples, unsigned int nr)
+{
+    unsigned int i;
+
+    for ( i = 0; i < nr; ++i )
+        samples[i] = samples[i] > overhead ? samples[i] - overhead : 0;
+}
+
+struct xtf_bench_stats xtf_bench_run(const char *name, void (*fn)(void),
+                                     unsigned int iterations)
+{
+    struct xtf_bench_stats stats;
+
+    if ( !overhead_valid )
+        calibrate_overhead();
+
+    iterations = min(iterations, XTF_BENCH_MAX_SAMPLES + 0u);
+
+    collect_samples(fn, iterations);
+
+    subtract_overhead(bench_samples, iterations);
+
+    xtf_bench_summarise(bench_samples, iterations, &stats);
+    xtf_bench_report(name, &stats);
+
+    return stats;
+}
+
+static void stress_warmup(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < XTF_BENCH_WARMUP; ++i )
+        stress.fn();
+}
+
+static void stress_collect(unsigned int cpu)
+{
+    uint64_t *samples = stress_samples[cpu], start;
+    unsigned int i;
+
+    for ( i = 0; i < stress.iterations; ++i )
+    {
+        start = xtf_bench_start();
+        stress.fn();
+        samples[i] = xtf_bench_end() - start;
+    }
+}
+
+/* Secondary vCPUs: warm up, then wait at the barrier for the boot vCPU. */
+static void stress_worker(void *unused)
+{
+    stress_warmup();
+
+    __sync_fetch_and_add(&stress.ready, 1);
+
+    while ( !LOAD_ACQUIRE(&stress.go) )
+        cpu_relax();
+
+    stress_collect(smp_processor_id());
+}
+
+int xtf_bench_stress(const char *name, void (*fn)(void),
+                     unsigned int iterations,
+                     struct xtf_bench_stress_stats *stats)
+{
+    unsigned int cpu, started, nr = xtf_nr_cpus();
+    unsigned long khz = xtf_tsc_khz();
+    uint64_t start, us;
+    char cpu_name[64];
+    int rc = 0;
+
+    memset(stats, 0, sizeof(*stats));
+
+    if ( !overhead_valid )
+        calibrate_overhead();
+
+    stress.fn = fn;
+    stress.iterations = min(iterations, XTF_BENCH_STRESS_MAX_SAMPLES + 0u);
+    stress.ready = 0;
+    stress.go = false;
+
+    for ( started = 1; started < nr; ++started )
+    {
+        rc = xtf_start_cpu(started, stress_worker, NULL);
+        if ( rc )
+            break;
+    }
+
+    if ( rc == 0 )
+    {
+        stress_warmup();
+
+        while ( ACCESS_ONCE(stress.ready) != nr - 1 )
+            cpu_relax();
+    }
+
+    /* Release the barrier.  On error, let any started vCPUs finish. */
+    start = xtf_bench_start();
+    STORE_RELEASE(&stress.go, true);
+
+    if ( rc == 0 )
+        stress_collect(0);
+
+    xtf_heartbeat();
+
+    for ( cpu = 1; cpu < started; ++cpu )
+        xtf_wait_cpu(cpu);
+
+    if ( rc )
+        return rc;
+
+    stats->cycles = xtf_bench_end() - start;
+    stats->nr_cpus = nr;
+    stats->ops = (uint64_t)nr * stress.iterations;
+
+    for ( cpu = 0; cpu < nr; ++cpu )
+    {
+        subtract_overhead(stress_samples[cpu], stress.iterations);
+        xtf_bench_summarise(stress_samples[cpu], stress.iterations,
+                            &stats->cpu[cpu]);
+
+        snprintf(cpu_name, sizeof(cpu_name), "%s/cpu%u", name, cpu);
+        xtf_bench_report(cpu_name, &stats->cpu[cpu]);
+    }
+
+    /* ops_per_sec = ops * 10^6 / elapsed microseconds. */
+    us = stats->cycles * 1000;
+    if ( khz )
+        divmod64(&us, khz);
+    if ( khz && us && us <= UINT32_MAX )
+    {
+        stats->ops_per_sec = stats->ops * 1000000;
+        divmod64(&stats->ops_per_sec, us);
+    }
+
+    printk("STRESS name=%s cpus=%u ops=%"PRIu64" cycles=%"PRIu64
+           " ops_per_sec=%"PRIu64"\n", name, stats->nr_cpus, stats->ops,
+           stats->cycles, stats->ops_per_sec);
+
+    xtf_report_metric(name, "cpus=%u ops=%"PRIu64" cycles=%"PRIu64
+                      " ops_per_sec=%"PRIu64, stats->nr_cpus, stats->ops,
+                      stats->cycles, stats->ops_per_sec);
+
+    return 0;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
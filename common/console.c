@@ -1,10 +1,12 @@
 #include <xtf/types.h>
 #include <xtf/atomic.h>
-#include <xtf/bitops.h>
 #include <xtf/console.h>
+#include <xtf/evtchn.h>
 #include <xtf/hypercall.h>
 #include <xtf/lib.h>
 #include <xtf/libc.h>
+#include <xtf/smp.h>
+#include <xtf/spinlock.h>
 #include <xtf/traps.h>
 
 /*
@@ -57,7 +59,7 @@ size_t pv_console_read_some(char *buf, size_t len)
     size_t s = 0;
     uint32_t cons, prod;
 
-    while ( !test_and_clear_bit(pv_evtchn, shared_info.evtchn_pending) ||
+    while ( !xtf_evtchn_test_and_clear(pv_evtchn) ||
             (pv_ring->in_cons == pv_ring->in_prod) )
         hypercall_poll(pv_evtchn);
 
@@ -73,21 +75,28 @@ size_t pv_console_read_some(char *buf, size_t len)
 }
 
 /*
- * Write some data into the pv ring, synchronously waiting for all data to be
- * consumed.
+ * Write some data into the pv ring.
+ *
+ * By default, synchronously wait for all data to be consumed.  If the test
+ * wants a buffered console, only wait if the ring is full, and only kick
+ * xenconsoled when the ring fills past half way.  console_flush() is
+ * responsible for pushing out the remainder.
  */
 static void pv_console_write(const char *buf, size_t len)
 {
+    const uint32_t watermark = sizeof(pv_ring->out) / 2;
     size_t written = 0;
     uint32_t cons = LOAD_ACQUIRE(&pv_ring->out_cons);
 
     do
     {
         /* Try and put some data into the ring. */
-        written = pv_console_write_some(&buf[written], len - written);
+        written += pv_console_write_some(&buf[written], len - written);
 
         /* Kick xenconsoled into action. */
-        hypercall_evtchn_send(pv_evtchn);
+        if ( !test_wants_buffered_console || (written < len) ||
+             (pv_ring->out_prod - ACCESS_ONCE(pv_ring->out_cons)) >= watermark )
+            hypercall_evtchn_send(pv_evtchn);
 
         /*
          * If we have more to write, the ring must have filled up.  Wait for
@@ -97,19 +106,34 @@ static void pv_console_write(const char *buf, size_t len)
         {
             while ( ACCESS_ONCE(pv_ring->out_cons) == cons )
                 hypercall_yield();
+
+            cons = ACCESS_ONCE(pv_ring->out_cons);
         }
 
     } while ( written < len );
 
     /* Wait for xenconsoled to consume all the data we gave. */
+    if ( !test_wants_buffered_console )
+        while ( ACCESS_ONCE(pv_ring->out_cons) != pv_ring->out_prod )
+            hypercall_yield();
+}
+
+void console_flush(void)
+{
+    if ( !pv_ring || pv_ring->out_cons == pv_ring->out_prod )
+        return;
+
+    hypercall_evtchn_send(pv_evtchn);
+
     while ( ACCESS_ONCE(pv_ring->out_cons) != pv_ring->out_prod )
         hypercall_yield();
 }
 
 void init_pv_console(xencons_interface_t *ring, evtchn_port_t port)
 {
-    if ( port >= (sizeof(shared_info.evtchn_pending) * CHAR_BIT) )
-        panic("evtchn %u out of evtchn_pending[] range\n", port);
+    if ( port >= xtf_evtchn_max_ports() )
+        panic("evtchn %u out of range for the %s ABI\n",
+              port, xtf_evtchn_abi_name());
 
     pv_ring = ring;
     pv_evtchn = port;
@@ -119,9 +143,23 @@ void init_pv_console(xencons_interface_t *ring, evtchn_port_t port)
 void vprintk(const char *fmt, va_list args)
 {
     static char buf[2048];
-    unsigned int i;
+    static spinlock_t lock = SPINLOCK_UNLOCKED;
+    static unsigned int owner = ~0u;
+    unsigned int i, cpu = smp_processor_id();
+    bool nested = ACCESS_ONCE(owner) == cpu;
     int rc;
 
+    /*
+     * Serialise output from multiple vCPUs.  A nested call on the same vCPU
+     * (e.g. a panic() from an exception taken while printing) mustn't
+     * deadlock, so proceeds without the lock.
+     */
+    if ( !nested )
+    {
+        spin_lock(&lock);
+        owner = cpu;
+    }
+
     rc = vsnprintf(buf, sizeof(buf), fmt, args);
 
     if ( rc > (int)sizeof(buf) )
@@ -129,6 +167,12 @@ void vprintk(const char *fmt, va_list args)
 
     for ( i = 0; i < nr_cons_cb; ++i )
         output_fns[i](buf, rc);
+
+    if ( !nested )
+    {
+        owner = ~0u;
+        spin_unlock(&lock);
+    }
 }
 
 void printk(const char *fmt, ...)
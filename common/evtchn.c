@@ -0,0 +1,379 @@
+/**
+ * @file common/evtchn.c
+ *
+ * Event channels, with upcall delivery.
+ */
+#include <xtf/atomic.h>
+#include <xtf/evtchn.h>
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+#include <xtf/smp.h>
+#include <xtf/traps.h>
+
+#include <arch/mm.h>
+
+static struct {
+    xtf_evtchn_handler_t fn;
+    void *arg;
+} handlers[XTF_EVTCHN_MAX_PORTS];
+
+static void dispatch(evtchn_port_t port);
+
+/*
+ * Dispatch all pending events for @cpu, under the 2-level ABI.  The port
+ * operations are in evtchn_abi.c.
+ */
+static void evtchn_2l_handle_events(unsigned int cpu)
+{
+    struct vcpu_info *vi = &shared_info.vcpu_info[cpu];
+    unsigned long sel, pending;
+    unsigned int word, bit;
+
+    while ( ACCESS_ONCE(vi->evtchn_upcall_pending) )
+    {
+        vi->evtchn_upcall_pending = 0;
+
+        sel = __sync_fetch_and_and(&vi->evtchn_pending_sel, 0);
+
+        while ( sel )
+        {
+            word = __builtin_ctzl(sel);
+            sel &= sel - 1;
+
+            pending = (ACCESS_ONCE(shared_info.evtchn_pending[word]) &
+                       ~ACCESS_ONCE(shared_info.evtchn_mask[word]));
+
+            while ( pending )
+            {
+                bit = __builtin_ctzl(pending);
+                pending &= pending - 1;
+
+                dispatch(word * BITS_PER_LONG + bit);
+            }
+        }
+    }
+}
+
+/*
+ * FIFO ABI.  An event word per port, in event array pages provided by the
+ * guest, holding the pending and mask bits, and a link to the next event in
+ * the same queue.  Xen links unmasked events onto the tail of a queue per
+ * priority, flagging the queue in the control block's ready field, and the
+ * guest consumes them from the head.
+ */
+#define FIFO_WORDS_PER_PAGE (PAGE_SIZE / sizeof(event_word_t))
+#define FIFO_ARRAY_PAGES    (XTF_EVTCHN_MAX_PORTS / FIFO_WORDS_PER_PAGE)
+
+/*
+ * Event words are 32 bits wide, and are operated on with explicitly sized
+ * atomics, rather than the generic bitops.
+ */
+#define FIFO_PENDING (1u << EVTCHN_FIFO_PENDING)
+#define FIFO_MASKED  (1u << EVTCHN_FIFO_MASKED)
+
+static event_word_t fifo_array[FIFO_ARRAY_PAGES][FIFO_WORDS_PER_PAGE]
+    __page_aligned_bss;
+
+static union {
+    struct evtchn_fifo_control_block cb;
+    uint8_t raw[PAGE_SIZE];
+} fifo_control __page_aligned_bss;
+
+/* The head of each queue, as far as it has been consumed. */
+static evtchn_port_t fifo_head[EVTCHN_FIFO_MAX_QUEUES];
+
+static event_word_t *fifo_word(evtchn_port_t port)
+{
+    return &fifo_array[port / FIFO_WORDS_PER_PAGE][port % FIFO_WORDS_PER_PAGE];
+}
+
+static void evtchn_fifo_mask(evtchn_port_t port)
+{
+    __sync_fetch_and_or(fifo_word(port), FIFO_MASKED);
+}
+
+static void evtchn_fifo_unmask(evtchn_port_t port)
+{
+    event_word_t *word = fifo_word(port);
+
+    __sync_fetch_and_and(word, ~FIFO_MASKED);
+
+    /*
+     * An event which became pending while masked wasn't linked.  Only then
+     * is Xen needed, to link it.
+     */
+    if ( ACCESS_ONCE(*word) & FIFO_PENDING )
+    {
+        struct evtchn_unmask unmask = { .port = port };
+
+        hypercall_event_channel_op(EVTCHNOP_unmask, &unmask);
+    }
+}
+
+static bool evtchn_fifo_is_pending(evtchn_port_t port)
+{
+    return ACCESS_ONCE(*fifo_word(port)) & FIFO_PENDING;
+}
+
+static bool evtchn_fifo_test_and_clear(evtchn_port_t port)
+{
+    return __sync_fetch_and_and(fifo_word(port), ~FIFO_PENDING) & FIFO_PENDING;
+}
+
+/*
+ * Unlink the event in @word from the head of its queue, returning the next
+ * port in the queue, or 0 if it was the tail.  Xen may be updating the link
+ * concurrently.
+ */
+static evtchn_port_t fifo_clear_linked(event_word_t *word)
+{
+    event_word_t old, new, w = ACCESS_ONCE(*word);
+
+    for ( ;; )
+    {
+        new = w & ~((1u << EVTCHN_FIFO_LINKED) | EVTCHN_FIFO_LINK_MASK);
+
+        old = __sync_val_compare_and_swap(word, w, new);
+        if ( old == w )
+            break;
+
+        w = old;
+    }
+
+    return w & EVTCHN_FIFO_LINK_MASK;
+}
+
+static void evtchn_fifo_handle_events(unsigned int cpu)
+{
+    struct vcpu_info *vi = &shared_info.vcpu_info[cpu];
+    struct evtchn_fifo_control_block *cb = &fifo_control.cb;
+    evtchn_port_t port;
+    uint32_t ready;
+    unsigned int q;
+
+    while ( ACCESS_ONCE(vi->evtchn_upcall_pending) )
+    {
+        vi->evtchn_upcall_pending = 0;
+
+        ready = __sync_fetch_and_and(&cb->ready, 0);
+
+        while ( ready )
+        {
+            /* Lowest numbered queues have the highest priority. */
+            q = __builtin_ctz(ready);
+
+            /*
+             * Having consumed to the tail, resume from the head Xen wrote
+             * when it next linked onto the empty queue.
+             */
+            port = fifo_head[q];
+            if ( !port )
+            {
+                smp_rmb();
+                port = ACCESS_ONCE(cb->head[q]);
+            }
+
+            fifo_head[q] = fifo_clear_linked(fifo_word(port));
+            if ( !fifo_head[q] )
+                ready &= ~(1u << q);
+
+            if ( !(ACCESS_ONCE(*fifo_word(port)) & FIFO_MASKED) )
+                dispatch(port);
+
+            ready |= __sync_fetch_and_and(&cb->ready, 0);
+        }
+    }
+}
+
+static const struct evtchn_abi evtchn_fifo = {
+    .name           = "fifo",
+    .max_ports      = XTF_EVTCHN_MAX_PORTS,
+    .mask           = evtchn_fifo_mask,
+    .unmask         = evtchn_fifo_unmask,
+    .is_pending     = evtchn_fifo_is_pending,
+    .test_and_clear = evtchn_fifo_test_and_clear,
+};
+
+static bool upcall_registered;
+
+static void dispatch(evtchn_port_t port)
+{
+    xtf_evtchn_handler_t fn;
+
+    /* Leave events for ports without a handler to whoever is polling. */
+    if ( port >= ARRAY_SIZE(handlers) ||
+         !(fn = LOAD_ACQUIRE(&handlers[port].fn)) )
+        return;
+
+    if ( evtchn_abi->test_and_clear(port) )
+        fn(port, handlers[port].arg);
+}
+
+/* C entry point for upcalls, from the arch specific stubs. */
+void do_evtchn_upcall(struct cpu_regs *regs)
+{
+    if ( !upcall_registered )
+        panic("Unexpected event channel upcall\n");
+
+    if ( ACCESS_ONCE(evtchn_abi) == &evtchn_fifo )
+        evtchn_fifo_handle_events(smp_processor_id());
+    else
+        evtchn_2l_handle_events(smp_processor_id());
+}
+
+int xtf_evtchn_init(void)
+{
+    int rc;
+
+    if ( upcall_registered )
+        return 0;
+
+    rc = arch_evtchn_init_upcall();
+    if ( rc )
+        return rc;
+
+    upcall_registered = true;
+
+    return 0;
+}
+
+int xtf_evtchn_init_fifo(void)
+{
+    struct evtchn_init_control init = {
+        .control_gfn = virt_to_gfn(&fifo_control),
+        .vcpu = 0,
+    };
+    struct evtchn_expand_array expand;
+    evtchn_port_t port;
+    unsigned int i;
+    int rc;
+
+    if ( evtchn_abi == &evtchn_fifo )
+        return 0;
+
+    /* Xen leaves masking to the guest.  Start with every port masked. */
+    for ( port = 0; port < XTF_EVTCHN_MAX_PORTS; ++port )
+        *fifo_word(port) = FIFO_MASKED;
+
+    rc = hypercall_event_channel_op(EVTCHNOP_init_control, &init);
+    if ( rc )
+        return rc;
+
+    /*
+     * Xen is now using the FIFO ABI, and can't be switched back.  Without
+     * the event array, events on every port (including the console's) are
+     * lost, so failure here is fatal.
+     */
+    for ( i = 0; i < FIFO_ARRAY_PAGES; ++i )
+    {
+        expand.array_gfn = virt_to_gfn(fifo_array[i]);
+
+        rc = hypercall_event_channel_op(EVTCHNOP_expand_array, &expand);
+        if ( rc )
+            panic("Failed to expand FIFO event array to %u pages: %d\n",
+                  i + 1, rc);
+    }
+
+    STORE_RELEASE(&evtchn_abi, &evtchn_fifo);
+
+    for ( port = 0; port < ARRAY_SIZE(handlers); ++port )
+        if ( handlers[port].fn )
+            evtchn_abi->unmask(port);
+
+    return 0;
+}
+
+int xtf_evtchn_alloc_unbound(domid_t remote)
+{
+    struct evtchn_alloc_unbound op = {
+        .dom = DOMID_SELF,
+        .remote_dom = remote,
+    };
+    int rc = hypercall_event_channel_op(EVTCHNOP_alloc_unbound, &op);
+
+    return rc ? rc : (int)op.port;
+}
+
+int xtf_evtchn_bind_interdomain(domid_t remote, evtchn_port_t remote_port)
+{
+    struct evtchn_bind_interdomain op = {
+        .remote_dom = remote,
+        .remote_port = remote_port,
+    };
+    int rc = hypercall_event_channel_op(EVTCHNOP_bind_interdomain, &op);
+
+    return rc ? rc : (int)op.local_port;
+}
+
+int xtf_evtchn_bind_virq(unsigned int virq, unsigned int vcpu)
+{
+    struct evtchn_bind_virq op = {
+        .virq = virq,
+        .vcpu = vcpu,
+    };
+    int rc = hypercall_event_channel_op(EVTCHNOP_bind_virq, &op);
+
+    return rc ? rc : (int)op.port;
+}
+
+int xtf_evtchn_bind_loopback(evtchn_port_t ports[2])
+{
+    int rc;
+
+    /* Xen treats DOMID_SELF as a remote domain of ourselves. */
+    rc = xtf_evtchn_alloc_unbound(DOMID_SELF);
+    if ( rc < 0 )
+        return rc;
+    ports[0] = rc;
+
+    rc = xtf_evtchn_bind_interdomain(DOMID_SELF, ports[0]);
+    if ( rc < 0 )
+    {
+        xtf_evtchn_close(ports[0]);
+        return rc;
+    }
+    ports[1] = rc;
+
+    return 0;
+}
+
+int xtf_evtchn_close(evtchn_port_t port)
+{
+    struct evtchn_close op = { .port = port };
+
+    if ( port < ARRAY_SIZE(handlers) )
+        xtf_evtchn_set_handler(port, NULL, NULL);
+
+    return hypercall_event_channel_op(EVTCHNOP_close, &op);
+}
+
+int xtf_evtchn_set_handler(evtchn_port_t port, xtf_evtchn_handler_t fn,
+                           void *arg)
+{
+    if ( port >= xtf_evtchn_max_ports() )
+        return -ERANGE;
+
+    if ( fn )
+    {
+        handlers[port].arg = arg;
+        STORE_RELEASE(&handlers[port].fn, fn);
+        evtchn_abi->unmask(port);
+    }
+    else
+    {
+        evtchn_abi->mask(port);
+        ACCESS_ONCE(handlers[port].fn) = NULL;
+    }
+
+    return 0;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
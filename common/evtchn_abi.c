@@ -0,0 +1,94 @@
+/**
+ * @file common/evtchn_abi.c
+ *
+ * Event channel port helpers, following the ABI in use.
+ *
+ * Kept apart from upcall delivery, so the PV console and xenbus drivers,
+ * which poll their ports, don't pull the handler table into every test.
+ */
+#include <xtf/bitops.h>
+#include <xtf/evtchn.h>
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+#include <xtf/traps.h>
+
+/*
+ * 2-level ABI.  A pending and a mask bit per port in shared_info, and a
+ * per-vCPU selector of the words of evtchn_pending[] which may have pending
+ * events.
+ */
+static void evtchn_2l_mask(evtchn_port_t port)
+{
+    test_and_set_bit(port, shared_info.evtchn_mask);
+}
+
+static void evtchn_2l_unmask(evtchn_port_t port)
+{
+    struct evtchn_unmask unmask = { .port = port };
+
+    /* Xen raises an upcall if the event became pending while masked. */
+    hypercall_event_channel_op(EVTCHNOP_unmask, &unmask);
+}
+
+static bool evtchn_2l_is_pending(evtchn_port_t port)
+{
+    return test_bit(port, shared_info.evtchn_pending);
+}
+
+static bool evtchn_2l_test_and_clear(evtchn_port_t port)
+{
+    return test_and_clear_bit(port, shared_info.evtchn_pending);
+}
+
+static const struct evtchn_abi evtchn_2l = {
+    .name           = "2l",
+    .max_ports      = sizeof(shared_info.evtchn_pending) * CHAR_BIT,
+    .mask           = evtchn_2l_mask,
+    .unmask         = evtchn_2l_unmask,
+    .is_pending     = evtchn_2l_is_pending,
+    .test_and_clear = evtchn_2l_test_and_clear,
+};
+
+const struct evtchn_abi *evtchn_abi = &evtchn_2l;
+
+const char *xtf_evtchn_abi_name(void)
+{
+    return evtchn_abi->name;
+}
+
+unsigned int xtf_evtchn_max_ports(void)
+{
+    return min(evtchn_abi->max_ports, XTF_EVTCHN_MAX_PORTS + 0u);
+}
+
+void xtf_evtchn_mask(evtchn_port_t port)
+{
+    if ( port < xtf_evtchn_max_ports() )
+        evtchn_abi->mask(port);
+}
+
+void xtf_evtchn_unmask(evtchn_port_t port)
+{
+    if ( port < xtf_evtchn_max_ports() )
+        evtchn_abi->unmask(port);
+}
+
+bool xtf_evtchn_is_pending(evtchn_port_t port)
+{
+    return port < xtf_evtchn_max_ports() && evtchn_abi->is_pending(port);
+}
+
+bool xtf_evtchn_test_and_clear(evtchn_port_t port)
+{
+    return port < xtf_evtchn_max_ports() && evtchn_abi->test_and_clear(port);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
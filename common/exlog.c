@@ -1,26 +1,76 @@
 #include <xtf/lib.h>
 #include <xtf/exlog.h>
 #include <xtf/numbers.h>
+#include <xtf/spinlock.h>
 
 static bool logging = false;
+static enum exlog_mode mode;
+
+/*
+ * Exceptions may be logged on any vCPU.  Serialises updates to the log
+ * state below.
+ */
+static spinlock_t lock = SPINLOCK_UNLOCKED;
+
+/*
+ * Storage for the log.  Either the default buffer, or one provided by the
+ * test to xtf_exlog_start_mode().
+ */
+static exlog_entry_t default_log[8];
+static exlog_entry_t *log = default_log;
+static unsigned int log_size = ARRAY_SIZE(default_log);
+
+/* Number of valid entries in log[]. */
 static unsigned int log_entries;
 
-static exlog_entry_t log[8];
+/* EXLOG_WRAP: Index of the next entry to overwrite, once log[] is full. */
+static unsigned int log_next;
+
+/* EXLOG_COUNT: Index of the most recently matched entry. */
+static unsigned int log_hit;
+
+/* Number of exceptions seen since the log was started or reset. */
+static unsigned long log_total;
+
+void xtf_exlog_start_mode(enum exlog_mode m, exlog_entry_t *buf,
+                          unsigned int nr)
+{
+    if ( !buf || !nr )
+    {
+        buf = default_log;
+        nr = ARRAY_SIZE(default_log);
+    }
+
+    xtf_exlog_stop();
+
+    spin_lock(&lock);
+    mode = m;
+    log = buf;
+    log_size = nr;
+    spin_unlock(&lock);
+
+    xtf_exlog_reset();
+    ACCESS_ONCE(logging) = true;
+}
 
 void xtf_exlog_start(void)
 {
-    logging = true;
-    log_entries = 0;
+    xtf_exlog_start_mode(EXLOG_PANIC, NULL, 0);
 }
 
 void xtf_exlog_reset(void)
 {
+    spin_lock(&lock);
     log_entries = 0;
+    log_next = 0;
+    log_hit = 0;
+    log_total = 0;
+    spin_unlock(&lock);
 }
 
 void xtf_exlog_stop(void)
 {
-    logging = false;
+    ACCESS_ONCE(logging) = false;
 }
 
 
@@ -29,47 +79,127 @@ unsigned int xtf_exlog_entries(void)
     return log_entries;
 }
 
+unsigned long xtf_exlog_total(void)
+{
+    return log_total;
+}
+
 exlog_entry_t *xtf_exlog_entry(unsigned int idx)
 {
-    if ( idx < ARRAY_SIZE(log) && idx < log_entries )
-        return &log[idx];
-    return NULL;
+    if ( idx >= log_entries )
+        return NULL;
+
+    /* Once wrapped, the oldest entry is the next one to be overwritten. */
+    if ( mode == EXLOG_WRAP && log_entries == log_size )
+    {
+        idx += log_next;
+        if ( idx >= log_size )
+            idx -= log_size;
+    }
+
+    return &log[idx];
 }
 
-void xtf_exlog_log_exception(struct cpu_regs *regs)
+static void fill_entry(exlog_entry_t *e, const struct cpu_regs *regs)
+{
+    e->ip = regs->ip;
+    e->cs = regs->cs;
+    e->ec = regs->error_code;
+    e->ev = regs->entry_vector;
+    e->count = 1;
+}
+
+/*
+ * Aggregate by vector and ip.  Exception stress tests typically fault
+ * repeatedly at a single site, so check the most recent match first.
+ */
+static void count_exception(const struct cpu_regs *regs)
 {
-    if ( !logging )
+    exlog_entry_t *e = &log[log_hit];
+    unsigned int i;
+
+    if ( log_entries && e->ip == regs->ip && e->ev == regs->entry_vector )
+    {
+        e->count++;
         return;
+    }
 
-    if ( log_entries < ARRAY_SIZE(log) )
+    for ( i = 0; i < log_entries; ++i )
     {
-        exlog_entry_t *e = &log[log_entries];
+        e = &log[i];
 
-        e->ip = regs->ip;
-        e->cs = regs->cs;
-        e->ec = regs->error_code;
-        e->ev = regs->entry_vector;
+        if ( e->ip == regs->ip && e->ev == regs->entry_vector )
+        {
+            e->count++;
+            log_hit = i;
+            return;
+        }
     }
-    else
+
+    /* New site.  If there is no room, it is only reflected in the total. */
+    if ( log_entries < log_size )
     {
+        log_hit = log_entries++;
+        fill_entry(&log[log_hit], regs);
+    }
+}
+
+void xtf_exlog_log_exception(struct cpu_regs *regs)
+{
+    if ( !ACCESS_ONCE(logging) )
+        return;
+
+    spin_lock(&lock);
+
+    log_total++;
+
+    if ( mode == EXLOG_COUNT )
+        count_exception(regs);
+    else if ( log_entries < log_size )
+        fill_entry(&log[log_entries++], regs);
+    else if ( mode == EXLOG_WRAP )
+    {
+        fill_entry(&log[log_next++], regs);
+        if ( log_next == log_size )
+            log_next = 0;
+    }
+    else if ( mode == EXLOG_PANIC )
+    {
+        spin_unlock(&lock);
+
         printk("Exception log full\n");
         xtf_exlog_dump_log();
         panic("Exception log full\n");
     }
+    /* else EXLOG_STOP: Only reflected in the total. */
 
-    log_entries++;
+    spin_unlock(&lock);
 }
 
 void xtf_exlog_dump_log(void)
 {
+    exlog_entry_t *e;
     unsigned int i;
 
     if ( log_entries == 0 )
         printk("No exception log entries\n");
     else
-        for ( i = 0; i < ARRAY_SIZE(log) && i < log_entries; ++i )
-            printk(" exlog[%02u] %04x:%p vec %u[%04x]\n",
-                   i, log[i].cs, _p(log[i].ip), log[i].ev, log[i].ec);
+    {
+        for ( i = 0; i < log_entries; ++i )
+        {
+            e = xtf_exlog_entry(i);
+
+            if ( mode == EXLOG_COUNT )
+                printk(" exlog[%02u] %04x:%p vec %u[%04x] x%lu\n",
+                       i, e->cs, _p(e->ip), e->ev, e->ec, e->count);
+            else
+                printk(" exlog[%02u] %04x:%p vec %u[%04x]\n",
+                       i, e->cs, _p(e->ip), e->ev, e->ec);
+        }
+
+        if ( log_total > log_entries && mode != EXLOG_COUNT )
+            printk(" %lu exceptions not shown\n", log_total - log_entries);
+    }
 }
 
 /*
@@ -8,12 +8,16 @@
 
 extern struct extable_entry __start_ex_table[], __stop_ex_table[];
 
+/*
+ * The table is sorted by build/sortextable.py when the image is linked, so
+ * can be searched directly.
+ */
 const struct extable_entry *search_extable(unsigned long addr)
 {
     const struct extable_entry *start = __start_ex_table,
         *stop = __stop_ex_table, *mid;
 
-    while ( start <= stop )
+    while ( start < stop )
     {
         mid = start + (stop - start) / 2;
 
@@ -22,40 +26,10 @@ const struct extable_entry *search_extable(unsigned long addr)
         else if ( addr > mid->fault )
             start = mid + 1;
         else
-            stop = mid - 1;
+            stop = mid;
     }
 
-    return 0;
-}
-
-static int compare_extable_entry(const void *_l, const void *_r)
-{
-    const struct extable_entry *l = _l, *r = _r;
-
-    if ( l->fault == r->fault )
-        return 0;
-    else if ( l->fault > r->fault )
-        return 1;
-    else
-        return -1;
-}
-
-static void swap_extable_entry(void *_l, void *_r)
-{
-    struct extable_entry tmp, *l = _l, *r = _r;
-
-    tmp = *l;
-    *l = *r;
-    *r = tmp;
-}
-
-void sort_extable(void)
-{
-    heapsort(__start_ex_table,
-             __stop_ex_table - __start_ex_table,
-             sizeof(__start_ex_table[0]),
-             compare_extable_entry,
-             swap_extable_entry);
+    return NULL;
 }
 
 /*
@@ -3,13 +3,19 @@
  *
  * A driver for the Xen Grant Table interface.
  */
+#include <xtf/barrier.h>
 #include <xtf/grant_table.h>
 #include <xtf/lib.h>
 
+#include <arch/mm.h>
+
 uint8_t gnttab_raw[] __page_aligned_bss;
 extern grant_entry_v1_t gnttab_v1[] __alias("gnttab_raw");
 extern grant_entry_v2_t gnttab_v2[] __alias("gnttab_raw");
 
+/* Number of frames mapped, and the format in use. */
+static unsigned int gnttab_frames, gnttab_version;
+
 const char *gntst_strerror(int err)
 {
     static const char *const errstr[] = GNTTABOP_error_msgs;
@@ -44,16 +50,101 @@ int xtf_init_grant_table(unsigned int version)
         /* Sufficiently old Xen which only knows about gnttab v1. */
         return -ENODEV;
 
-    static bool gnttab_mapped;
-    if ( !gnttab_mapped )
+    gnttab_version = version;
+
+    return xtf_gnttab_map_frames(1);
+}
+
+int xtf_gnttab_map_frames(unsigned int nr_frames)
+{
+    struct gnttab_query_size query = { .dom = DOMID_SELF };
+    int rc;
+
+    if ( nr_frames <= gnttab_frames )
+        return 0;
+
+    if ( nr_frames > XTF_GNTTAB_MAX_FRAMES )
+        return -E2BIG;
+
+    rc = hypercall_grant_table_op(GNTTABOP_query_size, &query, 1);
+    if ( rc == 0 && query.status == GNTST_okay &&
+         nr_frames > query.max_nr_frames )
+        return -ENOSPC;
+
+    rc = arch_map_gnttab(nr_frames);
+    if ( rc )
+        return rc;
+
+    gnttab_frames = nr_frames;
+
+    return 0;
+}
+
+unsigned int xtf_gnttab_nr_frames(void)
+{
+    return gnttab_frames;
+}
+
+unsigned int xtf_gnttab_nr_entries(void)
+{
+    if ( gnttab_version == 2 )
+        return gnttab_frames * (PAGE_SIZE / sizeof(grant_entry_v2_t));
+
+    return gnttab_frames * (PAGE_SIZE / sizeof(grant_entry_v1_t));
+}
+
+int xtf_gnttab_grant_range(grant_ref_t ref, unsigned int nr, domid_t domid,
+                           const void *va, uint16_t flags)
+{
+    const uint8_t *page = va;
+    unsigned int i;
+
+    if ( ref > xtf_gnttab_nr_entries() ||
+         nr > xtf_gnttab_nr_entries() - ref )
+        return -ERANGE;
+
+    for ( i = 0; i < nr; ++i, page += PAGE_SIZE )
     {
-        rc = arch_map_gnttab();
+        if ( gnttab_version == 2 )
+        {
+            grant_entry_v2_t *ent = &gnttab_v2[ref + i];
+
+            ent->full_page.hdr.domid = domid;
+            ent->full_page.frame = virt_to_gfn(page);
+            smp_wmb();
+            ent->full_page.hdr.flags = GTF_permit_access | flags;
+        }
+        else
+        {
+            grant_entry_v1_t *ent = &gnttab_v1[ref + i];
 
-        if ( !rc )
-            gnttab_mapped = true;
+            ent->domid = domid;
+            ent->frame = virt_to_gfn(page);
+            smp_wmb();
+            ent->flags = GTF_permit_access | flags;
+        }
+    }
+
+    return 0;
+}
+
+int xtf_gnttab_revoke_range(grant_ref_t ref, unsigned int nr)
+{
+    unsigned int i;
+
+    if ( ref > xtf_gnttab_nr_entries() ||
+         nr > xtf_gnttab_nr_entries() - ref )
+        return -ERANGE;
+
+    for ( i = 0; i < nr; ++i )
+    {
+        if ( gnttab_version == 2 )
+            ACCESS_ONCE(gnttab_v2[ref + i].hdr.flags) = 0;
+        else
+            ACCESS_ONCE(gnttab_v1[ref + i].flags) = 0;
     }
 
-    return rc;
+    return 0;
 }
 
 /*
@@ -24,6 +24,7 @@ void __noreturn panic(const char *fmt, ...)
 
     printk("******************************\n");
 
+    console_flush();
     hypercall_shutdown(SHUTDOWN_crash);
     arch_crash_hard();
 }
@@ -0,0 +1,78 @@
+/**
+ * @file common/multicall.c
+ *
+ * Batching of hypercalls with `HYPERVISOR_multicall`.
+ */
+#include <xtf/lib.h>
+#include <xtf/multicall.h>
+
+void xtf_multicall_init(struct xtf_multicall *mc, multicall_entry_t *calls,
+                        unsigned int size)
+{
+    memset(mc, 0, sizeof(*mc));
+
+    mc->calls = calls;
+    mc->size = size;
+}
+
+static void record_failure(struct xtf_multicall *mc, int rc,
+                           unsigned int idx, unsigned long op)
+{
+    if ( mc->rc )
+        return;
+
+    mc->rc = rc;
+    mc->failed_idx = idx;
+    mc->failed_op = op;
+}
+
+int xtf_multicall_flush(struct xtf_multicall *mc)
+{
+    unsigned int i;
+    long rc;
+
+    if ( mc->nr == 0 )
+        return mc->rc;
+
+    rc = hypercall_multicall(mc->calls, mc->nr);
+    if ( rc )
+        record_failure(mc, rc, mc->issued, __HYPERVISOR_multicall);
+    else
+    {
+        for ( i = 0; i < mc->nr; ++i )
+            if ( (long)mc->calls[i].result < 0 )
+                record_failure(mc, mc->calls[i].result, mc->issued + i,
+                               mc->calls[i].op);
+    }
+
+    mc->issued += mc->nr;
+    mc->nr = 0;
+
+    return mc->rc;
+}
+
+multicall_entry_t *xtf_multicall_add(struct xtf_multicall *mc,
+                                     unsigned long op)
+{
+    multicall_entry_t *call;
+
+    if ( mc->nr == mc->size )
+        xtf_multicall_flush(mc);
+
+    call = &mc->calls[mc->nr++];
+
+    memset(call, 0, sizeof(*call));
+    call->op = op;
+
+    return call;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
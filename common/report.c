@@ -1,6 +1,9 @@
+#include <xtf/bench.h>
 #include <xtf/lib.h>
 #include <xtf/report.h>
+#include <xtf/test.h>
 #include <xtf/hypercall.h>
+#include <xtf/xenstore.h>
 
 enum test_status {
     STATUS_RUNNING, /**< Test not yet completed.       */
@@ -16,6 +19,20 @@ static enum test_status status;
 /** Whether a warning has occurred. */
 static bool warnings;
 
+/** Number of reports of each status, and of warnings. */
+static unsigned int nr_reports[STATUS_FAILURE + 1], nr_warnings;
+
+/**
+ * Xenstore directory for structured results, or empty if the result channel
+ * is unavailable.  Probed on first use.
+ */
+static char result_dir[32];
+static bool result_probed;
+
+/** Number of heartbeats, and the TSC at the most recent one. */
+static unsigned int nr_heartbeats;
+static uint64_t last_heartbeat;
+
 static const char *status_to_str[] =
 {
 #define STA(x) [STATUS_ ## x] = #x
@@ -31,6 +48,8 @@ static const char *status_to_str[] =
 
 static void set_status(enum test_status s)
 {
+    nr_reports[s]++;
+
     if ( s > status )
         status = s;
 }
@@ -52,6 +71,7 @@ void xtf_success(const char *fmt, ...)
 void xtf_warning(const char *fmt, ...)
 {
     warnings = true;
+    nr_warnings++;
 
     if ( fmt )
     {
@@ -89,6 +109,9 @@ void xtf_error(const char *fmt, ...)
         vprintk(fmt, args);
         va_end(args);
     }
+
+    if ( test_wants_fail_fast )
+        xtf_exit();
 }
 
 void xtf_failure(const char *fmt, ...)
@@ -103,6 +126,98 @@ void xtf_failure(const char *fmt, ...)
         vprintk(fmt, args);
         va_end(args);
     }
+
+    if ( test_wants_fail_fast )
+        xtf_exit();
+}
+
+/*
+ * The runner opts in to the result channel by creating the domain with a
+ * handle (UUID) starting with "xtfr", and creating /tool/xtf/$DOMID,
+ * writeable by the test domain, before unpausing it.  Without it, results
+ * are only reported on the console.
+ *
+ * The handle is checked first, with a single hypercall, so tests run without
+ * a result channel never touch xenstore.
+ */
+static const char *get_result_dir(void)
+{
+    if ( !result_probed )
+    {
+        xen_domain_handle_t handle;
+        int domid = -1;
+
+        result_probed = true;
+
+        if ( !hypercall_xen_version(XENVER_guest_handle, handle) &&
+             !memcmp(handle, "xtfr", 4) )
+            domid = xtf_get_domid();
+
+        if ( domid >= 0 )
+        {
+            snprintf(result_dir, sizeof(result_dir), "/tool/xtf/%d", domid);
+
+            if ( !xenstore_read(result_dir) )
+                result_dir[0] = '\0';
+        }
+    }
+
+    return result_dir[0] ? result_dir : NULL;
+}
+
+static void result_vwrite(const char *key, const char *fmt, va_list args)
+{
+    static char path[128], value[256];
+    const char *dir = get_result_dir();
+
+    if ( !dir )
+        return;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, key);
+    vsnprintf(value, sizeof(value), fmt, args);
+
+    xenstore_write(path, value);
+}
+
+static void __printf(2, 3) result_write(const char *key, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    result_vwrite(key, fmt, args);
+    va_end(args);
+}
+
+void xtf_report_metric(const char *name, const char *fmt, ...)
+{
+    char key[96];
+    va_list args;
+
+    snprintf(key, sizeof(key), "metrics/%s", name);
+
+    va_start(args, fmt);
+    result_vwrite(key, fmt, args);
+    va_end(args);
+}
+
+void xtf_heartbeat(void)
+{
+    unsigned long khz;
+    uint64_t now, period;
+
+    if ( !get_result_dir() )
+        return;
+
+    /* Rate limit to once per second, or roughly so if the TSC is unknown. */
+    now = rdtsc();
+    khz = xtf_tsc_khz();
+    period = khz ? khz * 1000ull : 1ull << 31;
+
+    if ( nr_heartbeats && (now - last_heartbeat) < period )
+        return;
+
+    last_heartbeat = now;
+    result_write("heartbeat", "%u", ++nr_heartbeats);
 }
 
 void xtf_report_status(void)
@@ -114,6 +229,21 @@ void xtf_report_status(void)
            status_to_str[status],
            (warnings && (status == STATUS_SUCCESS)) ?
            " with warnings" : "");
+
+    /*
+     * The result line is printed first, so a test which has left xenstore
+     * unusable still reports its result on the console.  The runner waits
+     * (bounded) for the status on the result channel, if it created one.
+     */
+    result_write("counters/success", "%u", nr_reports[STATUS_SUCCESS]);
+    result_write("counters/warning", "%u", nr_warnings);
+    result_write("counters/skip",    "%u", nr_reports[STATUS_SKIP]);
+    result_write("counters/error",   "%u", nr_reports[STATUS_ERROR]);
+    result_write("counters/failure", "%u", nr_reports[STATUS_FAILURE]);
+    result_write("warnings", "%u", warnings);
+
+    /* Written last.  Its presence tells the runner the result is complete. */
+    result_write("status", "%s", status_to_str[status]);
 }
 
 bool xtf_status_reported(void)
@@ -124,6 +254,7 @@ bool xtf_status_reported(void)
 void xtf_exit(void)
 {
     xtf_report_status();
+    console_flush();
     hypercall_shutdown(SHUTDOWN_poweroff);
     panic("xtf_exit(): hypercall_shutdown(SHUTDOWN_poweroff) returned\n");
 }
@@ -1,5 +1,5 @@
 #include <xtf/atomic.h>
-#include <xtf/bitops.h>
+#include <xtf/evtchn.h>
 #include <xtf/hypercall.h>
 #include <xtf/lib.h>
 #include <xtf/traps.h>
@@ -11,8 +11,9 @@ static char payload[XENSTORE_PAYLOAD_MAX + 1];
 
 void init_xenbus(xenbus_interface_t *ring, evtchn_port_t port)
 {
-    if ( port >= (sizeof(shared_info.evtchn_pending) * CHAR_BIT) )
-        panic("evtchn %u out of evtchn_pending[] range\n", port);
+    if ( port >= xtf_evtchn_max_ports() )
+        panic("evtchn %u out of range for the %s ABI\n",
+              port, xtf_evtchn_abi_name());
 
     xb_ring = ring;
     xb_port = port;
@@ -40,7 +41,7 @@ static void xenbus_write(const void *data, size_t len)
         {
             hypercall_evtchn_send(xb_port);
 
-            if ( !test_and_clear_bit(xb_port, shared_info.evtchn_pending) )
+            if ( !xtf_evtchn_test_and_clear(xb_port) )
                 hypercall_poll(xb_port);
 
             continue;
@@ -84,7 +85,7 @@ static void xenbus_read(void *data, size_t len)
         {
             hypercall_evtchn_send(xb_port);
 
-            if ( !test_and_clear_bit(xb_port, shared_info.evtchn_pending) )
+            if ( !xtf_evtchn_test_and_clear(xb_port) )
                 hypercall_poll(xb_port);
 
             continue;
@@ -114,26 +115,17 @@ int xenstore_init(void)
     return xb_port ? 0 : -ENODEV;
 }
 
-const char *xenstore_read(const char *path)
+/*
+ * Read a reply header and payload, terminating the payload in payload[].
+ * Returns the reply type, or XS_INVALID if the payload was too large.
+ */
+static unsigned int xenstore_reply(void)
 {
-    struct xenstore_msg_hdr hdr = {
-        .type = XS_READ,
-        .len = strlen(path) + 1, /* Must send the NUL terminator. */
-    };
-
-    /* Write the header and path to read. */
-    xenbus_write(&hdr, sizeof(hdr));
-    xenbus_write(path, hdr.len);
-
-    /* Kick xenstored. */
-    hypercall_evtchn_send(xb_port);
+    struct xenstore_msg_hdr hdr;
 
     /* Read the response header. */
     xenbus_read(&hdr, sizeof(hdr));
 
-    if ( hdr.type != XS_READ )
-        return NULL;
-
     if ( hdr.len > XENSTORE_PAYLOAD_MAX )
     {
         /*
@@ -149,7 +141,7 @@ const char *xenstore_read(const char *path)
             hdr.len -= part;
         }
 
-        return NULL;
+        return XS_INVALID;
     }
 
     /* Read the response payload. */
@@ -158,9 +150,62 @@ const char *xenstore_read(const char *path)
     /* Safely terminate the reply, just in case xenstored didn't. */
     payload[hdr.len] = '\0';
 
+    return hdr.type;
+}
+
+const char *xenstore_read(const char *path)
+{
+    struct xenstore_msg_hdr hdr = {
+        .type = XS_READ,
+        .len = strlen(path) + 1, /* Must send the NUL terminator. */
+    };
+
+    /* Write the header and path to read. */
+    xenbus_write(&hdr, sizeof(hdr));
+    xenbus_write(path, hdr.len);
+
+    /* Kick xenstored. */
+    hypercall_evtchn_send(xb_port);
+
+    if ( xenstore_reply() != XS_READ )
+        return NULL;
+
     return payload;
 }
 
+int xenstore_write(const char *path, const char *value)
+{
+    size_t plen = strlen(path) + 1, vlen = strlen(value);
+    struct xenstore_msg_hdr hdr = {
+        .type = XS_WRITE,
+        .len = plen + vlen, /* NUL separated, but not terminated. */
+    };
+
+    if ( hdr.len > XENSTORE_PAYLOAD_MAX )
+        return -EINVAL;
+
+    /* Write the header, path and value. */
+    xenbus_write(&hdr, sizeof(hdr));
+    xenbus_write(path, plen);
+    xenbus_write(value, vlen);
+
+    /* Kick xenstored. */
+    hypercall_evtchn_send(xb_port);
+
+    switch ( xenstore_reply() )
+    {
+    case XS_WRITE:
+        return 0;
+
+    case XS_ERROR:
+        /* Xenstored replies with the name of the errno. */
+        return strcmp(payload, "EACCES") == 0 ? -EACCES : -EIO;
+
+    default:
+        return -EIO;
+    }
+}
+
 /*
  * Local variables:
  * mode: C
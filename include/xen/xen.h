@@ -64,6 +64,7 @@
 
 #ifndef __ASSEMBLY__
 typedef uint16_t domid_t;
+typedef uint8_t xen_domain_handle_t[16];
 #endif
 
 #define DOMID_FIRST_RESERVED (0x7ff0U)
@@ -72,6 +73,14 @@ typedef uint16_t domid_t;
 /* Commands to HYPERVISOR_console_io */
 #define CONSOLEIO_write                   0
 
+/*
+ * Virtual interrupts, bound to event channels with EVTCHNOP_bind_virq.
+ * (V) are per-vCPU, (G) are global.
+ */
+#define VIRQ_TIMER      0  /* V. Timebase update, and/or requested timeout.  */
+#define VIRQ_DEBUG      1  /* V. Request guest to dump debug info.           */
+#define VIRQ_CONSOLE    2  /* G. (DOM0) Bytes received on emergency console. */
+
 /*
  * Commands to HYPERVISOR_vm_assist().
  */
@@ -20,11 +20,16 @@
 
 /* Optional functionality */
 #include <xtf/atomic.h>
+#include <xtf/bench.h>
 #include <xtf/bitops.h>
 #include <xtf/elf.h>
+#include <xtf/evtchn.h>
 #include <xtf/exlog.h>
 #include <xtf/grant_table.h>
 #include <xtf/hypercall.h>
+#include <xtf/multicall.h>
+#include <xtf/smp.h>
+#include <xtf/spinlock.h>
 #include <xtf/traps.h>
 #include <xtf/xenbus.h>
 #include <xtf/xenstore.h>
@@ -0,0 +1,175 @@
+/**
+ * @file include/xtf/bench.h
+ *
+ * Microbenchmark harness.
+ *
+ * Times repeated invocations of a function in TSC cycles, and reports a
+ * summary of the distribution on the console, one line per benchmark, in the
+ * form:
+ *
+ * <pre>
+ *   BENCH name=$NAME iters=$N min=$C median=$C p99=$C max=$C overhead=$C tsc_khz=$K
+ * </pre>
+ *
+ * Cycle counts have the measured cost of the timing bracket itself
+ * (overhead) subtracted.  tsc_khz is the calibrated TSC frequency, or 0 if it
+ * could not be determined.
+ *
+ * Stress benchmarks run the same function concurrently on every vCPU, and
+ * additionally report the aggregate throughput as:
+ *
+ * <pre>
+ *   STRESS name=$NAME cpus=$N ops=$OPS cycles=$C ops_per_sec=$R
+ * </pre>
+ *
+ * Benchmarks which perform a known amount of work per iteration may also
+ * report the cost of each unit of work, and the throughput, as:
+ *
+ * <pre>
+ *   RATE name=$NAME $UNIT=$N cycles_each=$C per_sec=$R
+ * </pre>
+ *
+ * Each summary is also reported as metric $NAME (or $NAME/rate for RATE
+ * lines) on the result channel (see xtf_report_metric()).  Names may
+ * therefore contain '/', but otherwise only characters valid in a xenstore
+ * path.
+ */
+#ifndef XTF_BENCH_H
+#define XTF_BENCH_H
+
+#include <xtf/smp.h>
+#include <xtf/types.h>
+
+#include <arch/cpuid.h>
+#include <arch/lib.h>
+
+/** Maximum number of timed iterations of a single benchmark. */
+#define XTF_BENCH_MAX_SAMPLES 8192
+
+/** Untimed iterations performed before the timed ones, to warm caches. */
+#define XTF_BENCH_WARMUP      32
+
+/** Maximum number of timed iterations per vCPU of a stress benchmark. */
+#define XTF_BENCH_STRESS_MAX_SAMPLES 2048
+
+/** Summary of a set of cycle samples. */
+struct xtf_bench_stats
+{
+    unsigned int nr;    /**< Number of samples. */
+    uint64_t min;       /**< Fastest sample. */
+    uint64_t median;    /**< 50th percentile. */
+    uint64_t p99;       /**< 99th percentile. */
+    uint64_t max;       /**< Slowest sample. */
+};
+
+/**
+ * Benchmark @p fn.
+ *
+ * Calls @p fn for #XTF_BENCH_WARMUP untimed iterations, then @p iterations
+ * timed ones (capped at #XTF_BENCH_MAX_SAMPLES), each individually bracketed
+ * by serialising TSC reads.  The summary is reported on the console.
+ *
+ * @param name Benchmark name.  Must not contain whitespace.
+ * @param fn Function to time.
+ * @param iterations Number of timed iterations.
+ * @returns Summary of the timed iterations.
+ */
+struct xtf_bench_stats xtf_bench_run(const char *name, void (*fn)(void),
+                                     unsigned int iterations);
+
+/** Summary of a stress benchmark. */
+struct xtf_bench_stress_stats
+{
+    unsigned int nr_cpus;   /**< Number of vCPUs used. */
+    uint64_t ops;           /**< Total timed iterations, over all vCPUs. */
+    uint64_t cycles;        /**< Elapsed cycles, on the boot vCPU. */
+    uint64_t ops_per_sec;   /**< Aggregate throughput, or 0 if unknown. */
+    struct xtf_bench_stats cpu[XTF_MAX_CPUS]; /**< Per-vCPU latencies. */
+};
+
+/**
+ * Benchmark @p fn concurrently on all available vCPUs.
+ *
+ * The test must provide stacks for its secondary vCPUs with XTF_AP_STACKS(),
+ * or only the boot vCPU is available.
+ *
+ * Each vCPU performs #XTF_BENCH_WARMUP untimed iterations, then waits at a
+ * barrier until all vCPUs are ready, before performing @p iterations timed
+ * ones (capped at #XTF_BENCH_STRESS_MAX_SAMPLES).  The per-vCPU latencies
+ * and aggregate throughput are reported on the console.
+ *
+ * @p fn may use smp_processor_id() to select per-vCPU resources.
+ *
+ * @param name Benchmark name.  Must not contain whitespace.
+ * @param fn Function to time.
+ * @param iterations Number of timed iterations per vCPU.
+ * @param stats Summary of the benchmark.
+ * @returns 0, or -errno if the secondary vCPUs couldn't be started.
+ */
+int xtf_bench_stress(const char *name, void (*fn)(void),
+                     unsigned int iterations,
+                     struct xtf_bench_stress_stats *stats);
+
+/**
+ * Summarise an arbitrary set of cycle samples.
+ *
+ * For tests which collect their own samples.  @p samples is sorted in place.
+ */
+void xtf_bench_summarise(uint64_t *samples, unsigned int nr,
+                         struct xtf_bench_stats *stats);
+
+/**
+ * Report @p stats on the console in the BENCH line format.
+ *
+ * @param name Benchmark name.  Must not contain whitespace.
+ */
+void xtf_bench_report(const char *name, const struct xtf_bench_stats *stats);
+
+/**
+ * Report the cost of each of @p nr units of work in one iteration, and the
+ * resulting throughput, in the RATE line format.
+ *
+ * Derived from the median of @p stats.  The throughput is 0 if the TSC
+ * frequency is unknown.
+ *
+ * @param name Benchmark name.  Must not contain whitespace.
+ * @param unit Name of the units of work, e.g. "entries".
+ */
+void xtf_bench_report_rate(const char *name, const char *unit, unsigned int nr,
+                           const struct xtf_bench_stats *stats);
+
+/**
+ * Read the TSC, bracketed for timing the start of a region.
+ */
+static inline uint64_t xtf_bench_start(void)
+{
+    return rdtsc_start();
+}
+
+/**
+ * Read the TSC, bracketed for timing the end of a region.
+ */
+static inline uint64_t xtf_bench_end(void)
+{
+    return cpu_has_rdtscp ? rdtscp_end() : rdtsc_start();
+}
+
+/**
+ * TSC frequency in kHz, or 0 if unknown.
+ *
+ * Taken from Xen's vcpu_time_info scale if available, falling back to CPUID
+ * leaves 0x15 and 0x16.  Calibrated once, on first use.
+ */
+unsigned long xtf_tsc_khz(void);
+
+#endif /* XTF_BENCH_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
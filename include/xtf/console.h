@@ -22,6 +22,11 @@ void register_console_callback(cons_output_cb cb);
 void init_pv_console(xencons_interface_t *ring,
                      evtchn_port_t port);
 
+/*
+ * Wait for all buffered console output to be consumed.
+ */
+void console_flush(void);
+
 void vprintk(const char *fmt, va_list args) __printf(1, 0);
 void printk(const char *fmt, ...) __printf(1, 2);
 
@@ -0,0 +1,181 @@
+/**
+ * @file include/xtf/evtchn.h
+ *
+ * Event channels, with upcall delivery.
+ *
+ * Once xtf_evtchn_init() has been called, events are delivered to the boot
+ * vCPU by upcall: the event callback for PV guests, or the vector callback
+ * (#X86_VEC_EVTCHN) for HVM guests.  Upcalls are disabled until
+ * xtf_evtchn_upcalls_enable() is called.
+ *
+ * The upcall dispatches each pending, unmasked event to the handler
+ * installed for its port with xtf_evtchn_set_handler(), clearing the event
+ * first.  Handlers run with upcalls disabled.  Events on ports without a
+ * handler are left pending, for code which polls for them, such as the PV
+ * console and xenbus drivers.
+ *
+ * Event channel ABIs differ in how pending and masked events are
+ * represented.  The 2-level ABI, using the bitmaps in #shared_info, is in
+ * use until xtf_evtchn_init_fifo() switches to the FIFO ABI.  The port
+ * helpers here, and the PV console and xenbus drivers, follow the ABI in
+ * use.
+ */
+#ifndef XTF_EVTCHN_H
+#define XTF_EVTCHN_H
+
+#include <xtf/types.h>
+
+#include <xen/event_channel.h>
+#include <xen/xen.h>
+
+/**
+ * Number of ports the framework supports: the size of the handler table, and
+ * of the FIFO event array.
+ */
+#define XTF_EVTCHN_MAX_PORTS 8192
+
+/**
+ * Event handler.
+ *
+ * @param port The port the event arrived on.
+ * @param arg The argument given to xtf_evtchn_set_handler().
+ */
+typedef void (*xtf_evtchn_handler_t)(evtchn_port_t port, void *arg);
+
+/**
+ * Initialise event channel upcalls.
+ *
+ * Registers the upcall entry point with Xen.  Safe to be called multiple
+ * times.
+ *
+ * @returns 0 on success, or an error from Xen.
+ */
+int xtf_evtchn_init(void);
+
+/**
+ * Switch to the FIFO event channel ABI.
+ *
+ * Registers a control block for the boot vCPU, and an event array covering
+ * #XTF_EVTCHN_MAX_PORTS ports.  Events already pending stay pending.  All
+ * ports start masked, except for those with a handler.  Safe to be called
+ * multiple times, but there is no switching back.
+ *
+ * Must be called with upcalls disabled.
+ *
+ * @returns 0 on success, or an error from Xen, in which case the 2-level ABI
+ * remains in use.
+ */
+int xtf_evtchn_init_fifo(void);
+
+/**
+ * Name of the event channel ABI in use, suitable for use in benchmark names.
+ */
+const char *xtf_evtchn_abi_name(void);
+
+/**
+ * Number of ports the ABI in use supports, capped at #XTF_EVTCHN_MAX_PORTS.
+ */
+unsigned int xtf_evtchn_max_ports(void);
+
+/**
+ * Allocate a port for @p remote to bind to.
+ *
+ * @returns the port, or -errno.
+ */
+int xtf_evtchn_alloc_unbound(domid_t remote);
+
+/**
+ * Bind to port @p remote_port of domain @p remote.
+ *
+ * @returns the local port, or -errno.
+ */
+int xtf_evtchn_bind_interdomain(domid_t remote, evtchn_port_t remote_port);
+
+/**
+ * Bind to virtual interrupt @p virq (VIRQ_*) of vCPU @p vcpu.
+ *
+ * @returns the port, or -errno.
+ */
+int xtf_evtchn_bind_virq(unsigned int virq, unsigned int vcpu);
+
+/**
+ * Allocate a pair of ports connected to each other.
+ *
+ * An event sent on either port is raised on the other.
+ *
+ * @returns 0 on success, or -errno.
+ */
+int xtf_evtchn_bind_loopback(evtchn_port_t ports[2]);
+
+/**
+ * Close @p port, removing any handler.
+ *
+ * @returns 0 on success, or -errno.
+ */
+int xtf_evtchn_close(evtchn_port_t port);
+
+/**
+ * Install @p fn as the handler for @p port, and unmask the port.
+ *
+ * If @p fn is NULL, mask the port and remove its handler.
+ *
+ * @returns 0 on success, or -ERANGE if @p port can't have a handler.
+ */
+int xtf_evtchn_set_handler(evtchn_port_t port, xtf_evtchn_handler_t fn,
+                           void *arg);
+
+/*
+ * The port helpers below ignore ports at or above xtf_evtchn_max_ports().
+ */
+
+/** Mask @p port. */
+void xtf_evtchn_mask(evtchn_port_t port);
+
+/** Unmask @p port.  A pending event is delivered. */
+void xtf_evtchn_unmask(evtchn_port_t port);
+
+/** Whether an event is pending on @p port. */
+bool xtf_evtchn_is_pending(evtchn_port_t port);
+
+/** Clear a pending event on @p port, returning whether one was pending. */
+bool xtf_evtchn_test_and_clear(evtchn_port_t port);
+
+/**
+ * Enable upcalls on the current vCPU.
+ *
+ * Any event which became pending while upcalls were disabled is delivered
+ * before this function returns.
+ */
+void xtf_evtchn_upcalls_enable(void);
+
+/** Disable upcalls on the current vCPU. */
+void xtf_evtchn_upcalls_disable(void);
+
+/** Arch-specific registration of the upcall entry point. */
+int arch_evtchn_init_upcall(void);
+
+/* Port operations which differ between event channel ABIs. */
+struct evtchn_abi {
+    const char *name;
+    unsigned int max_ports;
+
+    void (*mask)(evtchn_port_t port);
+    void (*unmask)(evtchn_port_t port);
+    bool (*is_pending)(evtchn_port_t port);
+    bool (*test_and_clear)(evtchn_port_t port);
+};
+
+/* The ABI in use.  Only changed by xtf_evtchn_init_fifo(). */
+extern const struct evtchn_abi *evtchn_abi;
+
+#endif /* XTF_EVTCHN_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -4,17 +4,72 @@
 #include <xtf/types.h>
 #include <arch/regs.h>
 
-void xtf_exlog_start(void);
-void xtf_exlog_reset(void);
-void xtf_exlog_stop(void);
+/**
+ * Behaviour of the exception log once it is full.
+ */
+enum exlog_mode
+{
+    EXLOG_PANIC, /**< Dump the log and panic.  The default.               */
+    EXLOG_STOP,  /**< Keep the first entries, and only count the rest.    */
+    EXLOG_WRAP,  /**< Keep the most recent entries, as a ring buffer.     */
+    EXLOG_COUNT, /**< One entry per distinct vector and ip, with a count. */
+};
 
 typedef struct exlog_entry
 {
     unsigned long ip;
     uint16_t cs, ec, ev;
+    unsigned long count; /**< Occurrences.  Only above 1 for EXLOG_COUNT. */
 } exlog_entry_t;
 
+/**
+ * Start logging exceptions, into the default 8-entry log, in EXLOG_PANIC
+ * mode.  Clears any previous entries.
+ */
+void xtf_exlog_start(void);
+
+/**
+ * Start logging exceptions, in @p mode.  Clears any previous entries.
+ *
+ * Tests wanting a larger log provide their own storage, sized at build time,
+ * e.g.:
+ *
+ * <pre>
+ *   static exlog_entry_t log[4096];
+ *
+ *   xtf_exlog_start_mode(EXLOG_WRAP, log, ARRAY_SIZE(log));
+ * </pre>
+ *
+ * @param buf Storage for the log, or NULL for the default log.
+ * @param nr Number of entries in @p buf.
+ */
+void xtf_exlog_start_mode(enum exlog_mode mode, exlog_entry_t *buf,
+                          unsigned int nr);
+
+void xtf_exlog_reset(void);
+void xtf_exlog_stop(void);
+
+/*
+ * Exceptions on any vCPU are logged, with updates to the log serialised by a
+ * lock.  The accessors below are not serialised against logging, so are for
+ * use once other vCPUs have stopped taking exceptions.
+ */
+
+/**
+ * Number of entries available from xtf_exlog_entry().  For EXLOG_COUNT, the
+ * number of distinct sites recorded.
+ */
 unsigned int xtf_exlog_entries(void);
+
+/**
+ * Total number of exceptions seen, including any which were not recorded in
+ * an entry.
+ */
+unsigned long xtf_exlog_total(void);
+
+/**
+ * Retrieve entry @p idx, oldest first, or NULL if out of range.
+ */
 exlog_entry_t *xtf_exlog_entry(unsigned int idx);
 
 void xtf_exlog_log_exception(struct cpu_regs *regs);
@@ -80,15 +80,9 @@ struct extable_entry
                     const struct extable_entry *ex);
 };
 
-/**
- * Sort the exception table.  Required to be called once on boot to make
- * searching efficient.
- */
-void sort_extable(void);
-
 /**
  * Search the exception table to find the entry associated with a specific
- * faulting address.
+ * faulting address.  The table is sorted at build time.
  * @param addr Faulting address.
  * @returns Appropriate extable_entry, or NULL if no entry.
  */
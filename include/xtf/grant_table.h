@@ -8,11 +8,15 @@
 
 #include <xtf/hypercall.h>
 
+/** Maximum number of grant table frames which XTF can map. */
+#define XTF_GNTTAB_MAX_FRAMES 16
+
 /**
  * Raw grant table mapping from Xen.
- * Valid once arch_map_gnttab() has returned successfully.
+ * Valid once arch_map_gnttab() has returned successfully, for as many frames
+ * as have been mapped.
  */
-extern uint8_t gnttab_raw[PAGE_SIZE];
+extern uint8_t gnttab_raw[XTF_GNTTAB_MAX_FRAMES * PAGE_SIZE];
 
 /** Grant table in v1 format (aliases #gnttab_raw). */
 extern grant_entry_v1_t gnttab_v1[
@@ -23,9 +27,10 @@ extern grant_entry_v2_t gnttab_v2[
     sizeof(gnttab_raw) / sizeof(grant_entry_v2_t)];
 
 /**
- * Map the domains grant table under #gnttab_raw[].
+ * Map the first @p nr_frames frames of the domains grant table under
+ * #gnttab_raw[].  Xen grows the grant table as necessary.
  */
-int arch_map_gnttab(void);
+int arch_map_gnttab(unsigned int nr_frames);
 
 
 /**
@@ -44,6 +49,48 @@ const char *gntst_strerror(int err);
  */
 int xtf_init_grant_table(unsigned int version);
 
+/**
+ * Grow the mapped grant table to at least @p nr_frames frames.
+ *
+ * xtf_init_grant_table() maps a single frame.
+ *
+ * @returns 0 on success, -E2BIG if @p nr_frames exceeds
+ * #XTF_GNTTAB_MAX_FRAMES, -ENOSPC if it exceeds the domain's limit, or -EIO.
+ */
+int xtf_gnttab_map_frames(unsigned int nr_frames);
+
+/** Number of grant table frames currently mapped. */
+unsigned int xtf_gnttab_nr_frames(void);
+
+/**
+ * Number of grant entries in the mapped frames, in the current grant table
+ * format.
+ */
+unsigned int xtf_gnttab_nr_entries(void);
+
+/**
+ * Grant @p domid access to @p nr consecutive pages starting at @p va.
+ *
+ * Populates entries [@p ref, @p ref + @p nr) of the grant table, in
+ * the current grant table format.  Each entry is made valid only after its
+ * frame and domid have been written.
+ *
+ * @param flags Extra GTF_* flags (e.g. GTF_readonly), OR'd with
+ * GTF_permit_access.
+ * @returns 0 on success, or -ERANGE if the entries are not all mapped.
+ */
+int xtf_gnttab_grant_range(grant_ref_t ref, unsigned int nr, domid_t domid,
+                           const void *va, uint16_t flags);
+
+/**
+ * Revoke grant entries [@p ref, @p ref + @p nr).
+ *
+ * The entries must not be in use.
+ *
+ * @returns 0 on success, or -ERANGE if the entries are not all mapped.
+ */
+int xtf_gnttab_revoke_range(grant_ref_t ref, unsigned int nr);
+
 #endif /* XTF_GRANT_TABLE_H */
 
 /*
@@ -114,6 +114,12 @@ static inline long hypercall_grant_table_op(unsigned int cmd, void *args,
     return HYPERCALL3(long, __HYPERVISOR_grant_table_op, cmd, args, count);
 }
 
+static inline long hypercall_multicall(multicall_entry_t *list,
+                                      unsigned int nr)
+{
+    return HYPERCALL2(long, __HYPERVISOR_multicall, list, nr);
+}
+
 static inline long hypercall_vm_assist(unsigned int cmd, unsigned int type)
 {
     return HYPERCALL2(long, __HYPERVISOR_vm_assist, cmd, type);
@@ -0,0 +1,119 @@
+/**
+ * @file include/xtf/multicall.h
+ *
+ * Batching of hypercalls with `HYPERVISOR_multicall`.
+ *
+ * A batch is built up in a caller-provided array of multicall entries.  It is
+ * issued when explicitly flushed, or automatically when the array is full
+ * and another call is added.  Each call's result is checked once the batch
+ * has been issued, and the first failure is recorded.
+ *
+ * <pre>
+ *   static multicall_entry_t calls[32];
+ *   struct xtf_multicall mc;
+ *
+ *   xtf_multicall_init(&mc, calls, ARRAY_SIZE(calls));
+ *
+ *   for ( ... )
+ *       xtf_multicall_update_va_mapping(&mc, va, pte, UVMF_INVLPG);
+ *
+ *   if ( (rc = xtf_multicall_flush(&mc)) )
+ *       ... call mc.failed_idx of type mc.failed_op failed with rc ...
+ * </pre>
+ */
+#ifndef XTF_MULTICALL_H
+#define XTF_MULTICALL_H
+
+#include <xtf/hypercall.h>
+
+/** A batch of hypercalls under construction. */
+struct xtf_multicall
+{
+    multicall_entry_t *calls;  /**< Storage for the batch. */
+    unsigned int size;         /**< Capacity of @p calls. */
+    unsigned int nr;           /**< Calls queued, not yet issued. */
+    unsigned int issued;       /**< Calls issued since initialisation. */
+
+    int rc;                    /**< First error, or 0. */
+    unsigned int failed_idx;   /**< Index (of all calls issued) of the first
+                                    failure, or of the batch if the multicall
+                                    itself failed. */
+    unsigned long failed_op;   /**< Hypercall of the first failure. */
+};
+
+/**
+ * Prepare to batch calls into @p calls, of @p size entries.
+ */
+void xtf_multicall_init(struct xtf_multicall *mc, multicall_entry_t *calls,
+                        unsigned int size);
+
+/**
+ * Issue all queued calls, and check their results.
+ *
+ * A call has failed if its result is negative.  Calls are not short
+ * circuited; all queued calls are issued irrespective of earlier failures.
+ *
+ * @returns The first error since xtf_multicall_init(), or 0.
+ */
+int xtf_multicall_flush(struct xtf_multicall *mc);
+
+/**
+ * Queue hypercall @p op, whose arguments the caller fills in to the returned
+ * entry.  Flushes the batch first if it is full.
+ */
+multicall_entry_t *xtf_multicall_add(struct xtf_multicall *mc,
+                                     unsigned long op);
+
+/** Queue a call to `HYPERVISOR_update_va_mapping`. */
+static inline void xtf_multicall_update_va_mapping(
+    struct xtf_multicall *mc, unsigned long linear, uint64_t npte,
+    enum XEN_UVMF flags)
+{
+    multicall_entry_t *call =
+        xtf_multicall_add(mc, __HYPERVISOR_update_va_mapping);
+
+    call->args[0] = linear;
+#ifdef __x86_64__
+    call->args[1] = npte;
+    call->args[2] = flags;
+#else
+    call->args[1] = npte;
+    call->args[2] = npte >> 32;
+    call->args[3] = flags;
+#endif
+}
+
+/** Queue a call to `HYPERVISOR_mmuext_op`. */
+static inline void xtf_multicall_mmuext_op(
+    struct xtf_multicall *mc, const mmuext_op_t ops[], unsigned int count,
+    unsigned int *done, unsigned int foreigndom)
+{
+    multicall_entry_t *call = xtf_multicall_add(mc, __HYPERVISOR_mmuext_op);
+
+    call->args[0] = _u(ops);
+    call->args[1] = count;
+    call->args[2] = _u(done);
+    call->args[3] = foreigndom;
+}
+
+/** Queue a call to `HYPERVISOR_xen_version`. */
+static inline void xtf_multicall_xen_version(
+    struct xtf_multicall *mc, unsigned int cmd, void *arg)
+{
+    multicall_entry_t *call = xtf_multicall_add(mc, __HYPERVISOR_xen_version);
+
+    call->args[0] = cmd;
+    call->args[1] = _u(arg);
+}
+
+#endif /* XTF_MULTICALL_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -22,6 +22,20 @@
  *
  * If multiple statuses are reported, the most severe is the one which is
  * kept.
+ *
+ * The final status is printed on the console.  If the runner has provided a
+ * result channel (the xenstore directory /tool/xtf/$DOMID, writeable by the
+ * test, advertised by a domain handle starting with "xtfr"), the status is
+ * additionally written there, after the console line, in a structured form:
+ *
+ * <pre>
+ *   heartbeat           Count of xtf_heartbeat() calls, at most one per second
+ *   metrics/$NAME       Values from xtf_report_metric(), as they are reported
+ *   counters/$STATUS    Number of xtf_$STATUS() calls, for each status
+ *   counters/warning    Number of xtf_warning() calls
+ *   warnings            1 if any warnings occurred, otherwise 0
+ *   status              SUCCESS, SKIP, ERROR or FAILURE.  Written last.
+ * </pre>
  */
 
 /**
@@ -50,6 +64,8 @@ void xtf_skip(const char *fmt, ...) __printf(1, 2);
  *
  * Indicates an error with the test code, or environment, and not with the
  * subject matter under test.
+ *
+ * Exits the test if #test_wants_fail_fast.
  */
 void xtf_error(const char *fmt, ...) __printf(1, 2);
 
@@ -58,11 +74,34 @@ void xtf_error(const char *fmt, ...) __printf(1, 2);
  *
  * Indicates that the subject matter under test has failed to match
  * expectation.
+ *
+ * Exits the test if #test_wants_fail_fast.
  */
 void xtf_failure(const char *fmt, ...) __printf(1, 2);
 
 /**
- * Print a status report.
+ * Report a named metric, such as a benchmark result, on the result channel.
+ *
+ * Not printed on the console.  Does nothing if there is no result channel.
+ *
+ * @param name Metric name.  Must be a valid xenstore path component(s).
+ */
+void xtf_report_metric(const char *name, const char *fmt, ...) __printf(2, 3);
+
+/**
+ * Signal progress to the runner on the result channel.
+ *
+ * Long running tests should call this periodically, so a runner waiting for
+ * the test can tell a slow test from a stuck one.  Cheap to call often;
+ * updates are rate limited to roughly once a second.  Does nothing if there
+ * is no result channel.
+ *
+ * Only to be called on the boot vCPU.
+ */
+void xtf_heartbeat(void);
+
+/**
+ * Print a status report, and write it to the result channel if available.
  *
  * If a report has not yet been set, an error will occur.
  */
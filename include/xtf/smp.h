@@ -0,0 +1,98 @@
+/**
+ * @file include/xtf/smp.h
+ *
+ * Running code concurrently on secondary vCPUs.
+ *
+ * The boot vCPU (0) runs test_main().  Secondary vCPUs are brought up on
+ * demand with xtf_start_cpu(), each on its own stacks (and for HVM guests,
+ * its own TSS), and run a single function before going back offline.  A
+ * secondary vCPU may be started again once its previous function has
+ * returned.
+ *
+ * All vCPUs share the IDT/trap table as configured at boot, and the single
+ * user stack, so `exec_user_*()` and xtf_set_idte() are only suitable for use
+ * on the boot vCPU.
+ */
+#ifndef XTF_SMP_H
+#define XTF_SMP_H
+
+/** Maximum number of vCPUs used by the framework, including the boot vCPU. */
+#define XTF_MAX_CPUS 8
+
+#ifndef __ASSEMBLY__
+
+#include <xtf/compiler.h>
+#include <xtf/types.h>
+
+#include <arch/page.h>
+
+/**
+ * Provide stacks for @p nr secondary vCPUs, at file scope in the test.
+ *
+ * Each secondary vCPU needs 3 pages of stack, so the framework provides
+ * none, keeping them out of single-vCPU tests.  Tests which use
+ * xtf_start_cpu() (directly, or via xtf_bench_stress()) provide them with,
+ * e.g.:
+ *
+ * <pre>
+ *   XTF_AP_STACKS(XTF_MAX_CPUS - 1);
+ * </pre>
+ *
+ * which defines the stacks privately, and publishes them to the framework
+ * by overriding its weak ap_stacks pointer and nr_ap_stacks count, which
+ * default to NULL and 0.
+ */
+#define XTF_AP_STACKS(nr)                                               \
+    static uint8_t test_ap_stacks[(nr)][3 * PAGE_SIZE]                  \
+        __page_aligned_bss;                                             \
+    uint8_t (*const ap_stacks)[3 * PAGE_SIZE] = test_ap_stacks;         \
+    const unsigned int nr_ap_stacks = (nr)
+
+/**
+ * Index of the vCPU executing the caller.
+ *
+ * Derived from the current stack, so only valid when executing in kernel
+ * context.
+ */
+unsigned int smp_processor_id(void);
+
+/**
+ * Number of vCPUs available to the test, capped at #XTF_MAX_CPUS, and by the
+ * stacks provided with XTF_AP_STACKS().
+ */
+unsigned int xtf_nr_cpus(void);
+
+/**
+ * Run @p fn(@p arg) on secondary vCPU @p cpu.
+ *
+ * The vCPU is initialised on first use, then brought online.  It goes back
+ * offline when @p fn returns.
+ *
+ * @returns 0 on success, -EINVAL for a bad vCPU index, -EBUSY if @p cpu is
+ * still running a previous function, or an error from Xen.
+ */
+int xtf_start_cpu(unsigned int cpu, void (*fn)(void *), void *arg);
+
+/**
+ * Is @p cpu still running the function it was last started with?
+ */
+bool xtf_cpu_running(unsigned int cpu);
+
+/**
+ * Wait for @p cpu to return from the function it was last started with.
+ */
+void xtf_wait_cpu(unsigned int cpu);
+
+#endif /* __ASSEMBLY__ */
+
+#endif /* XTF_SMP_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
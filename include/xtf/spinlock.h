@@ -0,0 +1,46 @@
+/**
+ * @file include/xtf/spinlock.h
+ *
+ * Simple test-and-set spinlocks, for serialising between vCPUs.
+ */
+#ifndef XTF_SPINLOCK_H
+#define XTF_SPINLOCK_H
+
+#include <xtf/barrier.h>
+#include <xtf/lib.h>
+#include <xtf/types.h>
+
+typedef struct {
+    unsigned int lock;
+} spinlock_t;
+
+#define SPINLOCK_UNLOCKED { 0 }
+
+static inline __always_inline bool spin_trylock(spinlock_t *l)
+{
+    return !__sync_lock_test_and_set(&l->lock, 1);
+}
+
+static inline __always_inline void spin_lock(spinlock_t *l)
+{
+    while ( !spin_trylock(l) )
+        while ( ACCESS_ONCE(l->lock) )
+            cpu_relax();
+}
+
+static inline __always_inline void spin_unlock(spinlock_t *l)
+{
+    __sync_lock_release(&l->lock);
+}
+
+#endif /* XTF_SPINLOCK_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -38,6 +38,33 @@ extern bool xtf_has_fep;
  */
 extern bool test_wants_user_mappings;
 
+/**
+ * Boolean indicating whether the test wants buffered PV console output.
+ *
+ * By default, each write to the PV console waits for xenconsoled to consume
+ * the data, so output is never lost if the guest crashes hard.  Buffered
+ * output only notifies xenconsoled when the ring is half full, and when the
+ * test exits or panics, which is much faster for output-heavy tests.
+ *
+ * The framework variable is a weak reference, and may be overridden by a test
+ * wishing to change the default.
+ */
+extern bool test_wants_buffered_console;
+
+/**
+ * Boolean indicating whether the test wants to stop at the first error or
+ * failure.
+ *
+ * By default, a test continues after xtf_error() or xtf_failure(), reporting
+ * its final status when test_main() returns.  In fail-fast mode, the first
+ * xtf_error() or xtf_failure() immediately reports the status and exits,
+ * which shortens runs of tests which would otherwise keep failing in a loop.
+ *
+ * The framework variable is a weak reference, and may be overridden by a test
+ * wishing to change the default.
+ */
+extern bool test_wants_fail_fast;
+
 /**
  * Boolean indicating whether the test is entirely predicated on the available
  * of the Force Emulation Prefix.
@@ -21,6 +21,15 @@ int xenstore_init(void);
  */
 const char *xenstore_read(const char *key);
 
+/**
+ * Issue a #XS_WRITE operation of @p value to @p key, waiting synchronously
+ * for the reply.
+ *
+ * Returns 0 on success, -EACCES if xenstored refused permission, or -EIO for
+ * any other error.
+ */
+int xenstore_write(const char *key, const char *value);
+
 #endif /* XTF_XENSTORE_H */
 
 /*
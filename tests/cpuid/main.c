@@ -13,6 +13,8 @@
 
 const char test_title[] = "Guest cpuid information";
 
+bool test_wants_buffered_console = true;
+
 static void dump_leaves(cpuid_count_fn_t cpuid_fn)
 {
     uint32_t leaf = 0, subleaf = ~0U;
@@ -15,6 +15,8 @@
 
 const char test_title[] = "Guest MSR information";
 
+bool test_wants_buffered_console = true;
+
 void test_main(void)
 {
     unsigned int idx = 0;
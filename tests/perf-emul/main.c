@@ -0,0 +1,207 @@
+/**
+ * @file tests/perf-emul/main.c
+ * @ref test-perf-emul
+ *
+ * @page test-perf-emul Emulation cost
+ *
+ * Measure the cost of instructions which are intercepted and emulated by
+ * Xen, and of forcing instructions through the x86 instruction emulator using
+ * the Forced Emulation Prefix.
+ *
+ * Each instruction class is timed twice using the microbenchmark harness:
+ * once executed natively (`$CLASS/native`), which for most classes is a
+ * VMExit and trap-and-emulate, and once with the Forced Emulation Prefix
+ * (`$CLASS/fep`), which always takes the full emulator path.
+ *
+ * - `cpuid` - `cpuid`, leaf 0.
+ * - `rdmsr` - `rdmsr` of `MSR_APICBASE`.
+ * - `wrmsr` - `wrmsr` of `MSR_APICBASE`, with its current value.
+ * - `inb` - `inb` from port 0x61 (handled internally by Xen).
+ * - `outb` - `outb` to port 0x61, with its current value.
+ * - `invlpg` - `invlpg` of a data mapping.
+ * - `mov_cr0` - `mov` to @%cr0, with its current value.
+ * - `mov_cr3` - `mov` to @%cr3, with its current value.
+ * - `mov_mem` - A plain store to memory, which is never intercepted natively.
+ *
+ * Whether `invlpg` and `mov` to @%cr3 are intercepted natively depends on
+ * the paging mode, so the test is run in both HAP and shadow configurations.
+ *
+ * A table of median cycle counts is printed once all classes have been
+ * measured.
+ *
+ * @see tests/perf-emul/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "Emulation cost";
+
+bool test_needs_fep = true;
+
+#define ITERATIONS 2048
+
+static uint64_t apicbase;
+static unsigned long cr0, cr3;
+static uint8_t port_61;
+static unsigned long scratch;
+
+static void native_cpuid(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    cpuid_count(0, 0, &eax, &ebx, &ecx, &edx);
+}
+
+static void fep_cpuid(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    pv_cpuid_count(0, 0, &eax, &ebx, &ecx, &edx);
+}
+
+static void native_rdmsr(void)
+{
+    rdmsr(MSR_APICBASE);
+}
+
+static void fep_rdmsr(void)
+{
+    uint32_t lo, hi;
+
+    asm volatile (_ASM_XEN_FEP "rdmsr"
+                  : "=a" (lo), "=d" (hi)
+                  : "c" (MSR_APICBASE));
+}
+
+static void native_wrmsr(void)
+{
+    wrmsr(MSR_APICBASE, apicbase);
+}
+
+static void fep_wrmsr(void)
+{
+    asm volatile (_ASM_XEN_FEP "wrmsr"
+                  :: "c" (MSR_APICBASE), "a" ((uint32_t)apicbase),
+                     "d" ((uint32_t)(apicbase >> 32)));
+}
+
+static void native_inb(void)
+{
+    inb(0x61);
+}
+
+static void fep_inb(void)
+{
+    uint8_t val;
+
+    asm volatile (_ASM_XEN_FEP "inb %w1, %b0"
+                  : "=a" (val) : "Nd" (0x61));
+}
+
+static void native_outb(void)
+{
+    outb(port_61, 0x61);
+}
+
+static void fep_outb(void)
+{
+    asm volatile (_ASM_XEN_FEP "outb %b0, %w1"
+                  :: "a" (port_61), "Nd" (0x61));
+}
+
+static void native_invlpg(void)
+{
+    invlpg(&scratch);
+}
+
+static void fep_invlpg(void)
+{
+    asm volatile (_ASM_XEN_FEP "invlpg (%0)" :: "r" (&scratch));
+}
+
+static void native_mov_cr0(void)
+{
+    write_cr0(cr0);
+}
+
+static void fep_mov_cr0(void)
+{
+    asm volatile (_ASM_XEN_FEP "mov %0, %%cr0" :: "r" (cr0));
+}
+
+static void native_mov_cr3(void)
+{
+    write_cr3(cr3);
+}
+
+static void fep_mov_cr3(void)
+{
+    asm volatile (_ASM_XEN_FEP "mov %0, %%cr3" :: "r" (cr3));
+}
+
+static void native_mov_mem(void)
+{
+    asm volatile ("mov %1, %0" : "=m" (scratch) : "r" (0ul));
+}
+
+static void fep_mov_mem(void)
+{
+    asm volatile (_ASM_XEN_FEP "mov %1, %0" : "=m" (scratch) : "r" (0ul));
+}
+
+static const struct insn {
+    const char *name;
+    void (*native)(void);
+    void (*fep)(void);
+} insns[] = {
+    { "cpuid",   native_cpuid,   fep_cpuid   },
+    { "rdmsr",   native_rdmsr,   fep_rdmsr   },
+    { "wrmsr",   native_wrmsr,   fep_wrmsr   },
+    { "inb",     native_inb,     fep_inb     },
+    { "outb",    native_outb,    fep_outb    },
+    { "invlpg",  native_invlpg,  fep_invlpg  },
+    { "mov_cr0", native_mov_cr0, fep_mov_cr0 },
+    { "mov_cr3", native_mov_cr3, fep_mov_cr3 },
+    { "mov_mem", native_mov_mem, fep_mov_mem },
+};
+
+void test_main(void)
+{
+    struct xtf_bench_stats native[ARRAY_SIZE(insns)], fep[ARRAY_SIZE(insns)];
+    char name[32];
+    unsigned int i;
+
+    apicbase = rdmsr(MSR_APICBASE);
+    cr0 = read_cr0();
+    cr3 = read_cr3();
+    port_61 = inb(0x61);
+
+    printk("TSC frequency: %lu kHz\n", xtf_tsc_khz());
+
+    for ( i = 0; i < ARRAY_SIZE(insns); ++i )
+    {
+        snprintf(name, sizeof(name), "%s/native", insns[i].name);
+        native[i] = xtf_bench_run(name, insns[i].native, ITERATIONS);
+
+        snprintf(name, sizeof(name), "%s/fep", insns[i].name);
+        fep[i] = xtf_bench_run(name, insns[i].fep, ITERATIONS);
+    }
+
+    printk("\nMedian cycles:\n");
+    printk("  %-10s %10s %10s\n", "Insn", "Native", "FEP");
+
+    for ( i = 0; i < ARRAY_SIZE(insns); ++i )
+        printk("  %-10s %10"PRIu64" %10"PRIu64"\n",
+               insns[i].name, native[i].median, fep[i].median);
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
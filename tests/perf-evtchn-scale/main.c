@@ -0,0 +1,214 @@
+/**
+ * @file tests/perf-evtchn-scale/main.c
+ * @ref test-perf-evtchn-scale
+ *
+ * @page test-perf-evtchn-scale Event channel scalability
+ *
+ * Measure how the cost of event channel operations scales with the number
+ * of ports in use, as in a driver domain serving many frontends.
+ *
+ * The test allocates loopback pairs of ports, up to 3072 pairs, and handles
+ * one port of each pair by upcall.  For each count of pairs, and with upcalls
+ * disabled, a round consists of:
+ *
+ * - `pending/$ABI/$NR` - `EVTCHNOP_send` on every pair, leaving an event
+ *   pending on each masked port.
+ * - `unmask/$ABI/$NR` - Unmasking every port, which queues its event.
+ * - `consume/$ABI/$NR` - Enabling upcalls, and consuming every event in a
+ *   single upcall.
+ *
+ * For each phase, the microbenchmark harness reports a `BENCH` line in cycles
+ * per round, and a `RATE` line giving the cost of each event.
+ *
+ * The test runs first with the 2-level ABI (`$ABI` is `2l`), then, if Xen
+ * supports it, with the FIFO ABI (`$ABI` is `fifo`).  Counts which don't fit
+ * within the limits of the 2-level ABI are only measured with FIFO.  The test
+ * is configured with `max_event_channels = 8192`.
+ *
+ * @see tests/perf-evtchn-scale/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "Event channel scalability";
+
+#define ROUNDS    32
+#define MAX_PAIRS 3072
+
+static const unsigned int counts[] = { 16, 64, 256, 1024, MAX_PAIRS };
+
+/* Events are sent on tx[i], and handled on rx[i]. */
+static evtchn_port_t tx[MAX_PAIRS], rx[MAX_PAIRS];
+static unsigned int nr_pairs;
+
+static unsigned int consumed;
+
+enum { PENDING, UNMASK, CONSUME, NR_PHASES };
+
+static const char *const phase_names[NR_PHASES] = {
+    [PENDING] = "pending",
+    [UNMASK]  = "unmask",
+    [CONSUME] = "consume",
+};
+
+static uint64_t samples[NR_PHASES][ROUNDS];
+
+static void handler(evtchn_port_t port, void *arg)
+{
+    consumed++;
+}
+
+/*
+ * Allocate pairs until there are @p nr.  Returns 0 on success, or -errno if
+ * Xen ran out of ports, or the ABI in use can't track any more.
+ */
+static int alloc_pairs(unsigned int nr)
+{
+    evtchn_port_t ports[2];
+    int rc;
+
+    while ( nr_pairs < nr )
+    {
+        rc = xtf_evtchn_bind_loopback(ports);
+        if ( rc )
+            return rc;
+
+        rc = xtf_evtchn_set_handler(ports[1], handler, NULL);
+        if ( rc )
+        {
+            xtf_evtchn_close(ports[0]);
+            xtf_evtchn_close(ports[1]);
+            return rc;
+        }
+
+        /* Handled ports stay masked between rounds. */
+        xtf_evtchn_mask(ports[1]);
+
+        tx[nr_pairs] = ports[0];
+        rx[nr_pairs] = ports[1];
+        nr_pairs++;
+    }
+
+    return 0;
+}
+
+/* Run one round over @p nr pairs.  Returns false if events were lost. */
+static bool run_round(unsigned int nr, unsigned int round)
+{
+    unsigned int i, old = consumed;
+    uint64_t start;
+    bool ok = true;
+
+    start = xtf_bench_start();
+    for ( i = 0; i < nr; ++i )
+        if ( hypercall_evtchn_send(tx[i]) )
+            ok = false;
+    samples[PENDING][round] = xtf_bench_end() - start;
+
+    start = xtf_bench_start();
+    for ( i = 0; i < nr; ++i )
+        xtf_evtchn_unmask(rx[i]);
+    samples[UNMASK][round] = xtf_bench_end() - start;
+
+    start = xtf_bench_start();
+    xtf_evtchn_upcalls_enable();
+    samples[CONSUME][round] = xtf_bench_end() - start;
+
+    xtf_evtchn_upcalls_disable();
+
+    if ( consumed - old != nr )
+        ok = false;
+
+    for ( i = 0; i < nr; ++i )
+        xtf_evtchn_mask(rx[i]);
+
+    return ok;
+}
+
+/* Returns true if every count which fits ran without losing events. */
+static bool bench_abi(void)
+{
+    const char *abi = xtf_evtchn_abi_name();
+    struct xtf_bench_stats stats;
+    unsigned int c, r, p, nr;
+    char name[32];
+    int rc;
+
+    for ( c = 0; c < ARRAY_SIZE(counts); ++c )
+    {
+        nr = counts[c];
+
+        rc = alloc_pairs(nr);
+        if ( rc )
+        {
+            printk("%s ABI: Stopping at %u pairs: %d\n", abi, nr_pairs, rc);
+            break;
+        }
+
+        for ( r = 0; r < ROUNDS; ++r )
+        {
+            if ( !run_round(nr, r) )
+            {
+                xtf_failure("Fail: %s ABI, %u pairs: Events lost\n", abi, nr);
+                return false;
+            }
+        }
+
+        xtf_heartbeat();
+
+        for ( p = 0; p < NR_PHASES; ++p )
+        {
+            snprintf(name, sizeof(name), "%s/%s/%u", phase_names[p], abi, nr);
+
+            xtf_bench_summarise(samples[p], ROUNDS, &stats);
+            xtf_bench_report(name, &stats);
+            xtf_bench_report_rate(name, "events", nr, &stats);
+        }
+    }
+
+    return true;
+}
+
+void test_main(void)
+{
+    unsigned int i;
+    int rc;
+
+    rc = xtf_evtchn_init();
+    if ( rc )
+        return xtf_error("Error: Failed to initialise upcalls: %d\n", rc);
+
+    xtf_evtchn_upcalls_disable();
+
+    printk("TSC frequency: %lu kHz\n", xtf_tsc_khz());
+
+    if ( !bench_abi() )
+        return;
+
+    rc = xtf_evtchn_init_fifo();
+    if ( rc )
+        printk("FIFO ABI unavailable: %d\n", rc);
+    else
+    {
+        /*
+         * Switching ABI unmasks every port with a handler, but rounds expect
+         * the handled ports to start masked.
+         */
+        for ( i = 0; i < nr_pairs; ++i )
+            xtf_evtchn_mask(rx[i]);
+
+        if ( !bench_abi() )
+            return;
+    }
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
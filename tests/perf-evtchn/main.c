@@ -0,0 +1,261 @@
+/**
+ * @file tests/perf-evtchn/main.c
+ * @ref test-perf-evtchn
+ *
+ * @page test-perf-evtchn Event channel upcall latency
+ *
+ * Measure the latency of event channel delivery by upcall, which every PV
+ * frontend and backend depends on.
+ *
+ * The test binds a loopback pair of ports, so an event sent on one port is
+ * raised on the other, and handles both by upcall.  It first checks that
+ * events are held while upcalls are disabled or the port is masked, and
+ * delivered once when they are enabled or unmasked.  Then, with the
+ * microbenchmark harness, it reports:
+ *
+ * - `upcall/$ABI` - Cycles from just before `EVTCHNOP_send` on one port to
+ *   the start of the handler for the other port, measured from within the
+ *   handler.
+ * - `pingpong/$ABI` - Cycles for a round trip: an event sent on one port,
+ *   whose handler sends an event back on the other.  Followed by a `RATE`
+ *   line giving the events handled per second.
+ *
+ * The benchmarks are run first with the 2-level ABI (`$ABI` is `2l`), then, if
+ * Xen supports it, with the FIFO ABI (`$ABI` is `fifo`), for comparison.
+ *
+ * @see tests/perf-evtchn/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "Event channel upcall latency";
+
+#define ITERATIONS 4096
+
+/* Upper bound on waiting for an event which should already have arrived. */
+#define SPIN_LIMIT 1000000
+
+static evtchn_port_t ports[2];
+
+static unsigned int pings, pongs;
+static uint64_t ping_tsc;
+static bool bounce;
+
+static uint64_t samples[ITERATIONS];
+
+/* Lost events, or failed sends, seen during a benchmark. */
+static unsigned int errors;
+
+/* Handler for ports[1], i.e. events sent on ports[0]. */
+static void ping(evtchn_port_t port, void *arg)
+{
+    ping_tsc = xtf_bench_end();
+    ACCESS_ONCE(pings)++;
+
+    if ( bounce && hypercall_evtchn_send(ports[1]) )
+        errors++;
+}
+
+/* Handler for ports[0], i.e. events sent on ports[1]. */
+static void pong(evtchn_port_t port, void *arg)
+{
+    ACCESS_ONCE(pongs)++;
+}
+
+/* Wait for @p counter to move on from @p old.  Returns false on timeout. */
+static bool wait_for(const unsigned int *counter, unsigned int old)
+{
+    unsigned int i;
+
+    for ( i = 0; i < SPIN_LIMIT; ++i )
+    {
+        if ( ACCESS_ONCE(*counter) != old )
+            return true;
+
+        cpu_relax();
+    }
+
+    return false;
+}
+
+static void send_ping(void)
+{
+    if ( hypercall_evtchn_send(ports[0]) )
+        errors++;
+}
+
+static void pingpong(void)
+{
+    unsigned int old = ACCESS_ONCE(pongs);
+
+    send_ping();
+
+    if ( !wait_for(&pongs, old) )
+        errors++;
+}
+
+static void bench_upcall(const char *name)
+{
+    struct xtf_bench_stats stats;
+    unsigned int i, old;
+    uint64_t start;
+
+    for ( i = 0; i < ITERATIONS; ++i )
+    {
+        old = ACCESS_ONCE(pings);
+
+        start = xtf_bench_start();
+        send_ping();
+
+        if ( !wait_for(&pings, old) )
+        {
+            errors++;
+            return;
+        }
+
+        samples[i] = ping_tsc - start;
+    }
+
+    xtf_heartbeat();
+
+    xtf_bench_summarise(samples, ITERATIONS, &stats);
+    xtf_bench_report(name, &stats);
+}
+
+static void bench_pingpong(const char *name)
+{
+    struct xtf_bench_stats stats;
+
+    bounce = true;
+    stats = xtf_bench_run(name, pingpong, ITERATIONS);
+    bounce = false;
+
+    if ( !errors )
+        xtf_bench_report_rate(name, "events", 2, &stats);
+}
+
+/*
+ * Check that events are held while upcalls are disabled, or the port is
+ * masked, and delivered exactly once when they are re-enabled.
+ */
+static bool check_delivery(void)
+{
+    unsigned int old;
+
+    xtf_evtchn_upcalls_disable();
+
+    old = ACCESS_ONCE(pings);
+    send_ping();
+
+    if ( ACCESS_ONCE(pings) != old )
+    {
+        xtf_failure("Fail: Event delivered with upcalls disabled\n");
+        return false;
+    }
+
+    xtf_evtchn_upcalls_enable();
+
+    if ( ACCESS_ONCE(pings) != old + 1 )
+    {
+        xtf_failure("Fail: Expected 1 event on enabling upcalls, got %u\n",
+                    ACCESS_ONCE(pings) - old);
+        return false;
+    }
+
+    xtf_evtchn_mask(ports[1]);
+
+    old = ACCESS_ONCE(pings);
+    send_ping();
+
+    if ( ACCESS_ONCE(pings) != old )
+    {
+        xtf_failure("Fail: Event delivered on masked port\n");
+        return false;
+    }
+
+    xtf_evtchn_unmask(ports[1]);
+
+    if ( !wait_for(&pings, old) || ACCESS_ONCE(pings) != old + 1 )
+    {
+        xtf_failure("Fail: Expected 1 event on unmasking, got %u\n",
+                    ACCESS_ONCE(pings) - old);
+        return false;
+    }
+
+    return true;
+}
+
+/* Returns true if the checks and benchmarks passed for the ABI in use. */
+static bool bench_abi(void)
+{
+    char name[32];
+
+    printk("%s ABI\n", xtf_evtchn_abi_name());
+
+    if ( !check_delivery() )
+        return false;
+
+    snprintf(name, sizeof(name), "upcall/%s", xtf_evtchn_abi_name());
+    bench_upcall(name);
+    if ( errors )
+    {
+        xtf_failure("Fail: %s: %u events lost\n", name, errors);
+        return false;
+    }
+
+    snprintf(name, sizeof(name), "pingpong/%s", xtf_evtchn_abi_name());
+    bench_pingpong(name);
+    if ( errors )
+    {
+        xtf_failure("Fail: %s: %u events lost\n", name, errors);
+        return false;
+    }
+
+    xtf_evtchn_upcalls_disable();
+
+    return true;
+}
+
+void test_main(void)
+{
+    int rc;
+
+    rc = xtf_evtchn_init();
+    if ( rc )
+        return xtf_error("Error: Failed to initialise upcalls: %d\n", rc);
+
+    rc = xtf_evtchn_bind_loopback(ports);
+    if ( rc )
+        return xtf_error("Error: Failed to bind loopback ports: %d\n", rc);
+
+    printk("TSC frequency: %lu kHz, ports %u and %u\n",
+           xtf_tsc_khz(), ports[0], ports[1]);
+
+    if ( xtf_evtchn_set_handler(ports[0], pong, NULL) ||
+         xtf_evtchn_set_handler(ports[1], ping, NULL) )
+        return xtf_error("Error: Ports beyond the %u supported\n",
+                         xtf_evtchn_max_ports());
+
+    if ( !bench_abi() )
+        return;
+
+    rc = xtf_evtchn_init_fifo();
+    if ( rc )
+        printk("FIFO ABI unavailable: %d\n", rc);
+    else if ( !bench_abi() )
+        return;
+
+    xtf_evtchn_close(ports[0]);
+    xtf_evtchn_close(ports[1]);
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,202 @@
+/**
+ * @file tests/perf-exception/main.c
+ * @ref test-perf-exception
+ *
+ * @page test-perf-exception Exception delivery latency
+ *
+ * Measure the round-trip cost of raising and returning from exceptions.  For
+ * HVM guests, exceptions are delivered directly through the IDT, while for PV
+ * guests, every exception is taken by Xen and bounced to the guest's trap
+ * table, and returning requires the `iret` hypercall.
+ *
+ * Each exception is timed twice, with the microbenchmark harness reporting
+ * one `BENCH` line for each:
+ *
+ * - `fast/$EXC` - With a minimal handler installed, which resumes execution
+ *   directly, so the result is dominated by the cost of delivery and return.
+ * - `full/$EXC` - With XTF's regular handlers, including the exception log
+ *   and exception table lookup in do_exception().
+ *
+ * The exceptions are:
+ *
+ * - `ud` - @#UD from `ud2a`.
+ * - `gp` - @#GP from loading `%fs` with an unusable selector.
+ * - `pf` - @#PF from reading an unmapped address.  Not available in hvm32,
+ *   which runs without paging.
+ * - `db` - @#DB from `icebp`.
+ * - `bp` - @#BP from `int3`.
+ * - `int_N` - A software interrupt, `int $N`.  Fast handler only, as XTF
+ *   has no regular handler for it.
+ *
+ * @see tests/perf-exception/main.c
+ */
+#include <xtf.h>
+
+#include <arch/idt.h>
+
+const char test_title[] = "Exception delivery latency";
+
+#define ITERATIONS 4096
+
+void fast_handler(void);
+void fast_handler_ec(void);
+
+void entry_DB(void);
+void entry_BP(void);
+void entry_UD(void);
+void entry_GP(void);
+void entry_PF(void);
+
+/*
+ * Each raise_*() function raises its exception once.  The resume address is
+ * passed to the fast handler in %xdx, while the regular handlers use the
+ * exception table.
+ */
+static void raise_ud(void)
+{
+    unsigned long tmp;
+
+    asm volatile ("mov $1f, %[tmp];"
+                  "2: ud2a; 1:"
+                  _ASM_EXTABLE(2b, 1b)
+                  : [tmp] "=&d" (tmp) :: "memory");
+}
+
+static void raise_gp(void)
+{
+    unsigned long tmp;
+
+    asm volatile ("mov $1f, %[tmp];"
+                  "2: mov %[sel], %%fs; 1:"
+                  _ASM_EXTABLE(2b, 1b)
+                  : [tmp] "=&d" (tmp)
+                  : [sel] "r" (GDTE_AVAIL0 << 3)
+                  : "memory");
+}
+
+static void raise_pf(void)
+{
+    unsigned long tmp;
+    unsigned int val;
+
+    asm volatile ("mov $1f, %[tmp];"
+                  "2: mov 0, %[val]; 1:"
+                  _ASM_EXTABLE(2b, 1b)
+                  : [tmp] "=&d" (tmp), [val] "=&r" (val) :: "memory");
+}
+
+static void raise_db(void)
+{
+    unsigned long tmp;
+
+    asm volatile ("mov $1f, %[tmp];"
+                  ".byte 0xf1; 1:" /* icebp */
+                  _ASM_TRAP_OK(1b)
+                  : [tmp] "=&d" (tmp) :: "memory");
+}
+
+static void raise_bp(void)
+{
+    unsigned long tmp;
+
+    asm volatile ("mov $1f, %[tmp];"
+                  "int3; 1:"
+                  _ASM_TRAP_OK(1b)
+                  : [tmp] "=&d" (tmp) :: "memory");
+}
+
+static void raise_int_N(void)
+{
+    unsigned long tmp;
+
+    asm volatile ("mov $1f, %[tmp];"
+                  "int $%c[vec]; 1:"
+                  : [tmp] "=&d" (tmp)
+                  : [vec] "i" (X86_VEC_AVAIL)
+                  : "memory");
+}
+
+static const struct bench {
+    const char *name;
+    unsigned int vec;
+    void (*fn)(void);
+    void (*entry)(void); /* Regular handler, if any. */
+    unsigned int dpl;    /* DPL of the regular handler. */
+} benches[] = {
+    { "ud",    X86_EXC_UD,    raise_ud,    entry_UD, 0 },
+    { "gp",    X86_EXC_GP,    raise_gp,    entry_GP, 0 },
+    { "pf",    X86_EXC_PF,    raise_pf,    entry_PF, 0 },
+    { "db",    X86_EXC_DB,    raise_db,    entry_DB, 0 },
+    { "bp",    X86_EXC_BP,    raise_bp,    entry_BP, 3 },
+    { "int_N", X86_VEC_AVAIL, raise_int_N, NULL,     0 },
+};
+
+static int set_handler(unsigned int vec, void (*fn)(void), unsigned int dpl)
+{
+    struct xtf_idte idte = {
+        .addr = _u(fn),
+        .cs = __KERN_CS,
+        .dpl = dpl,
+    };
+
+    return xtf_set_idte(vec, &idte);
+}
+
+static void run_bench(const struct bench *b)
+{
+    bool has_ec = b->vec < 32 && ((1u << b->vec) & X86_EXC_HAVE_EC);
+    char name[32];
+    int rc;
+
+    if ( b->entry )
+    {
+        snprintf(name, sizeof(name), "full/%s", b->name);
+        xtf_bench_run(name, b->fn, ITERATIONS);
+    }
+
+    /* DPL3, so `int $N` is permitted from the (PV) kernel too. */
+    rc = set_handler(b->vec, has_ec ? fast_handler_ec : fast_handler, 3);
+    if ( rc )
+        return xtf_error("Error: Setting fast handler for %s: %d\n",
+                         b->name, rc);
+
+    snprintf(name, sizeof(name), "fast/%s", b->name);
+    xtf_bench_run(name, b->fn, ITERATIONS);
+
+    if ( b->entry )
+    {
+        rc = set_handler(b->vec, b->entry, b->dpl);
+        if ( rc )
+            panic("Failed to restore %s handler: %d\n", b->name, rc);
+    }
+}
+
+void test_main(void)
+{
+    unsigned int i;
+
+    printk("TSC frequency: %lu kHz\n", xtf_tsc_khz());
+
+    for ( i = 0; i < ARRAY_SIZE(benches); ++i )
+    {
+        if ( benches[i].vec == X86_EXC_PF && CONFIG_PAGING_LEVELS == 0 )
+        {
+            printk("Skipping %s: No paging\n", benches[i].name);
+            continue;
+        }
+
+        run_bench(&benches[i]);
+    }
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
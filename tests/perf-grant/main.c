@@ -0,0 +1,317 @@
+/**
+ * @file tests/perf-grant/main.c
+ * @ref test-perf-grant
+ *
+ * @page test-perf-grant Grant table operation throughput
+ *
+ * Measure the throughput of the grant table operations which make up the
+ * data path of PV network and block backends.
+ *
+ * The test maps 4 grant table frames, and grants 2 sets of 64 pages to
+ * itself, using references in the last frame.  For each grant table version
+ * which Xen supports, the microbenchmark harness reports one `BENCH` line per
+ * benchmark, in cycles per batch of 64 operations:
+ *
+ * - `copy/v$V/$LEN` - `GNTTABOP_copy` of `$LEN` bytes from each granted
+ *   page of the first set to the corresponding page of the second, by grant
+ *   reference, for `$LEN` of 64 (packet headers) and 4096 (whole pages).
+ * - `map/v$V` - (PV only) `GNTTABOP_map_grant_ref` of each page of the first
+ *   set, followed by `GNTTABOP_unmap_grant_ref`.
+ *
+ * Additionally, `set_version` reports the cost of switching the grant table
+ * from v1 to v2 and back, with 4 frames populated.
+ *
+ * Each benchmark is followed by a `RATE` line, giving the cost of each
+ * operation, and the throughput.
+ *
+ * @see tests/perf-grant/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "Grant table operation throughput";
+
+#define ITERATIONS 256
+#define NR_FRAMES  4
+#define BATCH      64
+
+static uint8_t src[BATCH][PAGE_SIZE] __page_aligned_bss;
+static uint8_t dst[BATCH][PAGE_SIZE] __page_aligned_bss;
+
+static struct gnttab_copy copies[BATCH];
+
+#ifdef CONFIG_PV
+/* Mapped over by grant maps, so never otherwise accessed. */
+static uint8_t map_area[BATCH][PAGE_SIZE] __page_aligned_bss;
+
+static struct gnttab_map_grant_ref maps[BATCH];
+static struct gnttab_unmap_grant_ref unmaps[BATCH];
+#endif
+
+static grant_ref_t src_ref, dst_ref;
+static domid_t domid;
+
+/* First error from a timed hypercall. */
+static long bench_rc;
+
+static void record_rc(long rc)
+{
+    if ( rc && !bench_rc )
+        bench_rc = rc;
+}
+
+static void copy_batch(void)
+{
+    record_rc(hypercall_grant_table_op(GNTTABOP_copy, copies, BATCH));
+}
+
+#ifdef CONFIG_PV
+static void map_unmap_batch(void)
+{
+    unsigned int i;
+
+    record_rc(hypercall_grant_table_op(GNTTABOP_map_grant_ref, maps, BATCH));
+
+    for ( i = 0; i < BATCH; ++i )
+        unmaps[i].handle = maps[i].handle;
+
+    record_rc(hypercall_grant_table_op(GNTTABOP_unmap_grant_ref,
+                                       unmaps, BATCH));
+}
+#endif
+
+static void switch_version(void)
+{
+    struct gnttab_set_version ver = { 2 };
+
+    record_rc(hypercall_grant_table_op(GNTTABOP_set_version, &ver, 1));
+
+    ver.version = 1;
+    record_rc(hypercall_grant_table_op(GNTTABOP_set_version, &ver, 1));
+}
+
+/*
+ * First bad per-operation status from the most recent batch of a benchmark,
+ * or 0.  Each checks only the op arrays its own benchmark uses.
+ */
+static int no_status(void)
+{
+    return 0;
+}
+
+static int copy_status(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        if ( copies[i].status != GNTST_okay )
+            return copies[i].status;
+
+    return 0;
+}
+
+#ifdef CONFIG_PV
+static int map_unmap_status(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+    {
+        if ( maps[i].status != GNTST_okay )
+            return maps[i].status;
+        if ( unmaps[i].status != GNTST_okay )
+            return unmaps[i].status;
+    }
+
+    return 0;
+}
+#endif
+
+/*
+ * Returns true if the benchmark ran without error.  @p batch_status checks
+ * the per-operation statuses of @p fn's ops.
+ */
+static bool run(const char *name, void (*fn)(void), int (*batch_status)(void),
+                const char *unit, unsigned int nr)
+{
+    struct xtf_bench_stats stats;
+    int status;
+
+    /* Check that the operations work before timing them. */
+    fn();
+    if ( !bench_rc && !(status = batch_status()) )
+    {
+        stats = xtf_bench_run(name, fn, ITERATIONS);
+
+        if ( !bench_rc && !(status = batch_status()) )
+        {
+            xtf_bench_report_rate(name, unit, nr, &stats);
+            return true;
+        }
+    }
+
+    if ( bench_rc )
+        xtf_failure("Fail: %s: rc %ld\n", name, bench_rc);
+    else
+        xtf_failure("Fail: %s: status %d: %s\n",
+                    name, status, gntst_strerror(status));
+
+    return false;
+}
+
+static void setup_copies(unsigned int len)
+{
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        copies[i] = (struct gnttab_copy){
+            .source = {
+                .u.ref = src_ref + i,
+                .domid = DOMID_SELF,
+            },
+            .dest = {
+                .u.ref = dst_ref + i,
+                .domid = DOMID_SELF,
+            },
+            .len = len,
+            .flags = GNTCOPY_source_gref | GNTCOPY_dest_gref,
+        };
+}
+
+/*
+ * Populate the grants for the current grant table version, using the last
+ * 2 * BATCH references of the table.
+ */
+static int setup_grants(void)
+{
+    int rc;
+
+    src_ref = xtf_gnttab_nr_entries() - 2 * BATCH;
+    dst_ref = src_ref + BATCH;
+
+    rc = xtf_gnttab_grant_range(src_ref, BATCH, domid, src, 0);
+    if ( !rc )
+        rc = xtf_gnttab_grant_range(dst_ref, BATCH, domid, dst, 0);
+
+    return rc;
+}
+
+/* Returns true if all benchmarks for version @p ver ran without error. */
+static bool bench_version(unsigned int ver)
+{
+    static const unsigned int lens[] = { 64, PAGE_SIZE };
+    char name[32];
+    unsigned int i;
+    int rc;
+
+    rc = setup_grants();
+    if ( rc )
+    {
+        xtf_error("Error: Failed to populate v%u grants: %d\n", ver, rc);
+        return false;
+    }
+
+    printk("Grant table v%u: %u entries, using refs %u to %u\n",
+           ver, xtf_gnttab_nr_entries(), src_ref, dst_ref + BATCH - 1);
+
+    for ( i = 0; i < ARRAY_SIZE(lens); ++i )
+    {
+        setup_copies(lens[i]);
+        snprintf(name, sizeof(name), "copy/v%u/%u", ver, lens[i]);
+
+        if ( !run(name, copy_batch, copy_status, "ops", BATCH) )
+            return false;
+    }
+
+#ifdef CONFIG_PV
+    for ( i = 0; i < BATCH; ++i )
+    {
+        maps[i] = (struct gnttab_map_grant_ref){
+            .host_addr = _u(map_area[i]),
+            .flags = GNTMAP_host_map,
+            .ref = src_ref + i,
+            .dom = domid,
+        };
+        unmaps[i] = (struct gnttab_unmap_grant_ref){
+            .host_addr = _u(map_area[i]),
+        };
+    }
+
+    snprintf(name, sizeof(name), "map/v%u", ver);
+    if ( !run(name, map_unmap_batch, map_unmap_status, "grants", BATCH) )
+        return false;
+#endif
+
+    /* No grants are in use, so the entries can simply be cleared. */
+    rc = xtf_gnttab_revoke_range(src_ref, 2 * BATCH);
+    if ( rc )
+    {
+        xtf_error("Error: Failed to revoke v%u grants: %d\n", ver, rc);
+        return false;
+    }
+
+    return true;
+}
+
+void test_main(void)
+{
+    bool have_v2;
+    int rc;
+
+    rc = xtf_get_domid();
+    if ( rc < 0 )
+        return xtf_error("Error: Failed to get domid\n");
+    domid = rc;
+
+    rc = xtf_init_grant_table(1);
+    if ( rc )
+        return xtf_error("Error: Failed to initialise grant table: %d\n", rc);
+
+    rc = xtf_gnttab_map_frames(NR_FRAMES);
+    if ( rc == -ENOSPC )
+        return xtf_skip("Skip: Domain limited to fewer than %u grant frames\n",
+                        NR_FRAMES);
+    else if ( rc )
+        return xtf_error("Error: Failed to map %u grant frames: %d\n",
+                         NR_FRAMES, rc);
+
+    printk("TSC frequency: %lu kHz, %u grant frames\n",
+           xtf_tsc_khz(), xtf_gnttab_nr_frames());
+
+    if ( !bench_version(1) )
+        return;
+
+    rc = xtf_init_grant_table(2);
+    have_v2 = !rc;
+    if ( rc && rc != -ENODEV )
+        return xtf_error("Error: Failed to switch to grant table v2: %d\n",
+                         rc);
+
+    if ( have_v2 )
+    {
+        if ( !bench_version(2) )
+            return;
+
+        /* Switch back, so the timed switches start from v1. */
+        rc = xtf_init_grant_table(1);
+        if ( rc )
+            return xtf_error("Error: Failed to switch to grant table v1: %d\n",
+                             rc);
+
+        if ( !run("set_version", switch_version, no_status, "switches", 2) )
+            return;
+    }
+    else
+        printk("Grant table v2 unavailable\n");
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,178 @@
+/**
+ * @file tests/perf-multicall/main.c
+ * @ref test-perf-multicall
+ *
+ * @page test-perf-multicall Multicall batching
+ *
+ * Measure how much batching hypercalls with `HYPERVISOR_multicall` amortises
+ * the cost of entering Xen, as PV kernels do for pagetable updates.
+ *
+ * Each benchmark times a batch of 32 calls, issued either individually
+ * (`single`), or as one multicall (`multicall`) built with the framework's
+ * multicall builder.  The microbenchmark harness reports one `BENCH` line
+ * per benchmark, in cycles per batch:
+ *
+ * - `xen_version/$MODE` - `XENVER_version`.
+ * - `update_va_mapping/$MODE` - (PV only) Rewriting the PTE of a page, with
+ *   `UVMF_INVLPG`, for each of 32 pages.
+ * - `mmuext_op/$MODE` - (PV only) `MMUEXT_INVLPG_LOCAL` for each of 32
+ *   pages, one op per call.  Additionally `mmuext_op/array`, issuing all 32
+ *   ops in a single call, as the mmuext_op interface natively allows.
+ *
+ * @see tests/perf-multicall/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "Multicall batching";
+
+#define ITERATIONS 1024
+#define BATCH      32
+
+static multicall_entry_t calls[BATCH];
+static struct xtf_multicall mc;
+
+/* First error from an individually issued hypercall, or 0. */
+static long bench_rc;
+
+/* Errors are -errno.  XENVER_version returns the (positive) version. */
+static void record_rc(long rc)
+{
+    if ( rc < 0 && !bench_rc )
+        bench_rc = rc;
+}
+
+static void xen_version_single(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        record_rc(hypercall_xen_version(XENVER_version, NULL));
+}
+
+static void xen_version_multicall(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        xtf_multicall_xen_version(&mc, XENVER_version, NULL);
+
+    xtf_multicall_flush(&mc);
+}
+
+#ifdef CONFIG_PV
+static uint8_t scratch[BATCH][PAGE_SIZE] __page_aligned_bss;
+static mmuext_op_t invlpg_ops[BATCH];
+
+static void update_va_mapping_single(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        record_rc(hypercall_update_va_mapping(
+                      _u(scratch[i]),
+                      pte_from_virt(scratch[i], PF_SYM(AD, RW, P)),
+                      UVMF_INVLPG));
+}
+
+static void update_va_mapping_multicall(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        xtf_multicall_update_va_mapping(
+            &mc, _u(scratch[i]), pte_from_virt(scratch[i], PF_SYM(AD, RW, P)),
+            UVMF_INVLPG);
+
+    xtf_multicall_flush(&mc);
+}
+
+static void mmuext_op_single(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        record_rc(hypercall_mmuext_op(&invlpg_ops[i], 1, NULL, DOMID_SELF));
+}
+
+static void mmuext_op_multicall(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        xtf_multicall_mmuext_op(&mc, &invlpg_ops[i], 1, NULL, DOMID_SELF);
+
+    xtf_multicall_flush(&mc);
+}
+
+static void mmuext_op_array(void)
+{
+    record_rc(hypercall_mmuext_op(invlpg_ops, BATCH, NULL, DOMID_SELF));
+}
+#endif
+
+static const struct bench {
+    const char *name;
+    void (*fn)(void);
+} benches[] = {
+    { "xen_version/single",          xen_version_single },
+    { "xen_version/multicall",       xen_version_multicall },
+#ifdef CONFIG_PV
+    { "update_va_mapping/single",    update_va_mapping_single },
+    { "update_va_mapping/multicall", update_va_mapping_multicall },
+    { "mmuext_op/single",            mmuext_op_single },
+    { "mmuext_op/multicall",         mmuext_op_multicall },
+    { "mmuext_op/array",             mmuext_op_array },
+#endif
+};
+
+static void report_failure(const char *name)
+{
+    if ( bench_rc )
+        xtf_failure("Fail: %s: rc %ld\n", name, bench_rc);
+    else
+        xtf_failure("Fail: %s: call %u (op %lu) failed: %d\n",
+                    name, mc.failed_idx, mc.failed_op, mc.rc);
+}
+
+void test_main(void)
+{
+    unsigned int i;
+
+#ifdef CONFIG_PV
+    for ( i = 0; i < BATCH; ++i )
+    {
+        invlpg_ops[i].cmd = MMUEXT_INVLPG_LOCAL;
+        invlpg_ops[i].arg1.linear_addr = _u(scratch[i]);
+    }
+#endif
+
+    printk("TSC frequency: %lu kHz, %u calls per batch\n",
+           xtf_tsc_khz(), BATCH);
+
+    for ( i = 0; i < ARRAY_SIZE(benches); ++i )
+    {
+        xtf_multicall_init(&mc, calls, ARRAY_SIZE(calls));
+
+        /* Check that each variant works before timing it. */
+        benches[i].fn();
+        if ( bench_rc || mc.rc )
+            return report_failure(benches[i].name);
+
+        xtf_bench_run(benches[i].name, benches[i].fn, ITERATIONS);
+
+        if ( bench_rc || mc.rc )
+            return report_failure(benches[i].name);
+    }
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
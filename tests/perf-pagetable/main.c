@@ -0,0 +1,226 @@
+/**
+ * @file tests/perf-pagetable/main.c
+ * @ref test-perf-pagetable
+ *
+ * @page test-perf-pagetable PV pagetable validation throughput
+ *
+ * Measure the cost of Xen's PV pagetable validation, which PV guests pay on
+ * every pagetable update, fork and exec.
+ *
+ * The test builds a set of pagetables which are not hooked into the live
+ * address space.  Every L1 entry maps a single data page read-write.  The
+ * microbenchmark harness reports one `BENCH` line per benchmark, in cycles
+ * per iteration:
+ *
+ * - `mmu_update/$N` - Filling all entries of a pinned L1 table, then
+ *   clearing them again, with `HYPERVISOR_mmu_update` batches of `$N`
+ *   entries, for `$N` of 1, 8, 64 and 512.
+ * - `pin_l1` - Pinning 8 populated L1 tables with one `MMUEXT_PIN_L1_TABLE`
+ *   array, then unpinning them.
+ * - `pin_l2` - Pinning an L2 table which references the 8 populated L1
+ *   tables, then unpinning it.  Xen validates the L1 tables recursively.
+ *
+ * Each benchmark is followed by a `RATE` line, giving the cost of each unit
+ * of work (an L1 entry written, or a table validated), and the throughput.
+ *
+ * @see tests/perf-pagetable/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "PV pagetable validation throughput";
+
+#define ITERATIONS 256
+#define NR_L1      8
+
+static intpte_t l1t[NR_L1][L1_PT_ENTRIES] __page_aligned_bss;
+static intpte_t l2t[L2_PT_ENTRIES] __page_aligned_bss;
+static uint8_t data[PAGE_SIZE] __page_aligned_bss;
+
+static mmu_update_t fill[L1_PT_ENTRIES], clear[L1_PT_ENTRIES];
+static mmuext_op_t pin_l1[NR_L1], unpin_l1[NR_L1];
+static mmuext_op_t pin_l2, unpin_l2;
+
+/* Batch size for the mmu_update benchmark in progress. */
+static unsigned int batch;
+
+/* First error from a timed hypercall. */
+static long bench_rc;
+
+static void record_rc(long rc)
+{
+    if ( rc && !bench_rc )
+        bench_rc = rc;
+}
+
+static void mmu_update_batched(void)
+{
+    unsigned int i;
+
+    for ( i = 0; i < L1_PT_ENTRIES; i += batch )
+        record_rc(hypercall_mmu_update(&fill[i], batch, NULL, DOMID_SELF));
+
+    for ( i = 0; i < L1_PT_ENTRIES; i += batch )
+        record_rc(hypercall_mmu_update(&clear[i], batch, NULL, DOMID_SELF));
+}
+
+static void pin_unpin_l1(void)
+{
+    record_rc(hypercall_mmuext_op(pin_l1, NR_L1, NULL, DOMID_SELF));
+    record_rc(hypercall_mmuext_op(unpin_l1, NR_L1, NULL, DOMID_SELF));
+}
+
+static void pin_unpin_l2(void)
+{
+    record_rc(hypercall_mmuext_op(&pin_l2, 1, NULL, DOMID_SELF));
+    record_rc(hypercall_mmuext_op(&unpin_l2, 1, NULL, DOMID_SELF));
+}
+
+/* Point fill[] and clear[] at every entry of @p table. */
+static void target_table(const intpte_t *table, intpte_t val)
+{
+    unsigned int i;
+
+    for ( i = 0; i < L1_PT_ENTRIES; ++i )
+    {
+        fill[i].ptr  = virt_to_maddr(&table[i]) | MMU_NORMAL_PT_UPDATE;
+        fill[i].val  = val;
+        clear[i].ptr = fill[i].ptr;
+        clear[i].val = 0;
+    }
+}
+
+static void run(const char *name, void (*fn)(void), const char *unit,
+                unsigned int nr)
+{
+    struct xtf_bench_stats stats;
+
+    /* Check that the operations work before timing them. */
+    fn();
+    if ( bench_rc )
+        return;
+
+    stats = xtf_bench_run(name, fn, ITERATIONS);
+    if ( bench_rc )
+        return;
+
+    xtf_bench_report_rate(name, unit, nr, &stats);
+}
+
+void test_main(void)
+{
+    static const unsigned int batches[] = { 1, 8, 64, 512 };
+    unsigned int i;
+    char name[32];
+    long rc;
+
+    /* Pagetables may only be mapped read-only by the guest. */
+    for ( i = 0; i < NR_L1; ++i )
+        if ( hypercall_update_va_mapping(
+                 _u(l1t[i]), pte_from_virt(l1t[i], PF_SYM(AD, P)),
+                 UVMF_INVLPG) )
+            return xtf_error("Error: Failed to remap l1t[%u] read-only\n", i);
+
+    if ( hypercall_update_va_mapping(
+             _u(l2t), pte_from_virt(l2t, PF_SYM(AD, P)), UVMF_INVLPG) )
+        return xtf_error("Error: Failed to remap l2t read-only\n");
+
+    for ( i = 0; i < NR_L1; ++i )
+    {
+        pin_l1[i].cmd = MMUEXT_PIN_L1_TABLE;
+        pin_l1[i].arg1.mfn = virt_to_mfn(l1t[i]);
+        unpin_l1[i].cmd = MMUEXT_UNPIN_TABLE;
+        unpin_l1[i].arg1.mfn = virt_to_mfn(l1t[i]);
+    }
+
+    pin_l2.cmd = MMUEXT_PIN_L2_TABLE;
+    pin_l2.arg1.mfn = virt_to_mfn(l2t);
+    unpin_l2.cmd = MMUEXT_UNPIN_TABLE;
+    unpin_l2.arg1.mfn = virt_to_mfn(l2t);
+
+    printk("TSC frequency: %lu kHz\n", xtf_tsc_khz());
+
+    /*
+     * Populate every L1 table.  Each must be pinned while it is written, and
+     * retains its contents once unpinned.  They are left pinned for the
+     * mmu_update benchmarks, which use the last table.
+     */
+    rc = hypercall_mmuext_op(pin_l1, NR_L1, NULL, DOMID_SELF);
+    if ( rc )
+        return xtf_error("Error: Failed to pin L1 tables: %ld\n", rc);
+
+    for ( i = 0; i < NR_L1; ++i )
+    {
+        target_table(l1t[i], pte_from_virt(data, PF_SYM(AD, RW, P)));
+
+        rc = hypercall_mmu_update(fill, L1_PT_ENTRIES, NULL, DOMID_SELF);
+        if ( rc )
+            return xtf_error("Error: Failed to populate l1t[%u]: %ld\n",
+                             i, rc);
+    }
+
+    for ( i = 0; i < ARRAY_SIZE(batches); ++i )
+    {
+        batch = batches[i];
+        snprintf(name, sizeof(name), "mmu_update/%u", batch);
+
+        /* Two updates of every entry per iteration. */
+        run(name, mmu_update_batched, "entries", 2 * L1_PT_ENTRIES);
+        if ( bench_rc )
+            return xtf_failure("Fail: %s: rc %ld\n", name, bench_rc);
+    }
+
+    /* Leave every L1 table populated, but unpinned. */
+    rc = hypercall_mmu_update(fill, L1_PT_ENTRIES, NULL, DOMID_SELF);
+    if ( rc )
+        return xtf_error("Error: Failed to repopulate L1 table: %ld\n", rc);
+
+    rc = hypercall_mmuext_op(unpin_l1, NR_L1, NULL, DOMID_SELF);
+    if ( rc )
+        return xtf_error("Error: Failed to unpin L1 tables: %ld\n", rc);
+
+    run("pin_l1", pin_unpin_l1, "tables", NR_L1);
+    if ( bench_rc )
+        return xtf_failure("Fail: pin_l1: rc %ld\n", bench_rc);
+
+    /*
+     * Point the first entries of the L2 table at the L1 tables.  As before,
+     * it must be pinned while it is written.
+     */
+    rc = hypercall_mmuext_op(&pin_l2, 1, NULL, DOMID_SELF);
+    if ( rc )
+        return xtf_error("Error: Failed to pin L2 table: %ld\n", rc);
+
+    for ( i = 0; i < NR_L1; ++i )
+    {
+        mmu_update_t mu = {
+            .ptr = virt_to_maddr(&l2t[i]) | MMU_NORMAL_PT_UPDATE,
+            .val = pte_from_virt(l1t[i], PF_SYM(AD, RW, P)),
+        };
+
+        rc = hypercall_mmu_update(&mu, 1, NULL, DOMID_SELF);
+        if ( rc )
+            return xtf_error("Error: Failed to populate l2t[%u]: %ld\n",
+                             i, rc);
+    }
+
+    rc = hypercall_mmuext_op(&unpin_l2, 1, NULL, DOMID_SELF);
+    if ( rc )
+        return xtf_error("Error: Failed to unpin L2 table: %ld\n", rc);
+
+    /* The L2 table, and every L1 table it references. */
+    run("pin_l2", pin_unpin_l2, "tables", NR_L1 + 1);
+    if ( bench_rc )
+        return xtf_failure("Fail: pin_l2: rc %ld\n", bench_rc);
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
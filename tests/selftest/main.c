@@ -149,6 +149,108 @@ static void test_exlog(void)
     xtf_exlog_stop();
 }
 
+/*
+ * Raise @p nr exceptions from a single site.  The loop is in asm, so the
+ * compiler can't unroll it into multiple sites.
+ */
+static void __noinline exlog_int3s(unsigned int nr)
+{
+    asm volatile ("1: int3; 2:"
+                  _ASM_TRAP_OK(2b)
+                  "dec %[nr]; jnz 1b"
+                  : [nr] "+r" (nr));
+}
+
+static void __noinline exlog_ud2as(unsigned int nr)
+{
+    asm volatile ("1: ud2a; 2:"
+                  _ASM_EXTABLE(1b, 2b)
+                  "dec %[nr]; jnz 1b"
+                  : [nr] "+r" (nr));
+}
+
+static bool check_exlog_total(unsigned long nr)
+{
+    unsigned long total = xtf_exlog_total();
+
+    if ( total != nr )
+    {
+        xtf_failure("Fail: expected %lu exceptions, got %lu\n", nr, total);
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_exlog_vec(unsigned int entry, unsigned int ev,
+                            unsigned long count)
+{
+    exlog_entry_t *e = xtf_exlog_entry(entry);
+
+    if ( !e )
+    {
+        xtf_failure("Fail: unable to retrieve log entry %u\n", entry);
+        return false;
+    }
+
+    if ( (e->ev != ev) || (e->count != count) )
+    {
+        xtf_failure("Fail: exlog entry %u:\n"
+                    "  Expected: vec %u x%lu\n"
+                    "       Got: vec %u x%lu\n",
+                    entry, ev, count, e->ev, e->count);
+        return false;
+    }
+
+    return true;
+}
+
+static void test_exlog_modes(void)
+{
+    static exlog_entry_t log[4];
+
+    printk("Test: Exception Logging modes\n");
+
+    /* Stop: The first 4 exceptions are kept. */
+    xtf_exlog_start_mode(EXLOG_STOP, log, ARRAY_SIZE(log));
+
+    exlog_int3s(3);
+    exlog_ud2as(3);
+
+    if ( !check_nr_entries(4) || !check_exlog_total(6) ||
+         !check_exlog_vec(0, X86_EXC_BP, 1) ||
+         !check_exlog_vec(3, X86_EXC_UD, 1) )
+        goto out;
+
+    /* Wrap: The last 4 exceptions are kept, oldest first. */
+    xtf_exlog_start_mode(EXLOG_WRAP, log, ARRAY_SIZE(log));
+
+    exlog_int3s(3);
+    exlog_ud2as(3);
+
+    if ( !check_nr_entries(4) || !check_exlog_total(6) ||
+         !check_exlog_vec(0, X86_EXC_BP, 1) ||
+         !check_exlog_vec(1, X86_EXC_UD, 1) ||
+         !check_exlog_vec(3, X86_EXC_UD, 1) )
+        goto out;
+
+    /* Count: One entry per site. */
+    xtf_exlog_start_mode(EXLOG_COUNT, log, ARRAY_SIZE(log));
+
+    exlog_int3s(1000);
+    exlog_ud2as(10);
+    exlog_int3s(5);
+
+    if ( !check_nr_entries(2) || !check_exlog_total(1015) ||
+         !check_exlog_vec(0, X86_EXC_BP, 1005) ||
+         !check_exlog_vec(1, X86_EXC_UD, 10) )
+        goto out;
+
+ out:
+    xtf_exlog_reset();
+    xtf_exlog_stop();
+}
+
 enum {
     USER_not_seen,
     USER_seen,
@@ -367,6 +469,7 @@ void test_main(void)
 
     test_extable();
     test_exlog();
+    test_exlog_modes();
     test_exec_user();
     if ( CONFIG_PAGING_LEVELS > 0 )
         test_NULL_unmapped();
@@ -0,0 +1,102 @@
+/**
+ * @file tests/smp/main.c
+ * @ref test-smp
+ *
+ * @page test-smp SMP
+ *
+ * Sanity checks for secondary vCPU bring-up.
+ *
+ * Each secondary vCPU is started, and records the result of
+ * smp_processor_id() and the function argument it was passed.  This is
+ * repeated several times, to check that vCPUs can be restarted once their
+ * function has returned, and that the vCPUs can run concurrently.
+ *
+ * The test is configured with 4 vCPUs, and is skipped if only one is
+ * available.
+ *
+ * @see tests/smp/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "SMP sanity checks";
+
+XTF_AP_STACKS(XTF_MAX_CPUS - 1);
+
+#define ROUNDS 3
+
+static unsigned int seen_id[XTF_MAX_CPUS];
+static unsigned long seen_arg[XTF_MAX_CPUS];
+
+static void record(void *arg)
+{
+    unsigned int cpu = smp_processor_id();
+
+    seen_id[cpu] = cpu;
+    seen_arg[cpu] = _u(arg);
+
+    printk("  Hello from vCPU %u\n", cpu);
+}
+
+void test_main(void)
+{
+    unsigned int cpu, round, nr = xtf_nr_cpus();
+    int rc;
+
+    printk("%u vCPUs available\n", nr);
+
+    if ( nr < 2 )
+        return xtf_skip("Skip: Need at least 2 vCPUs\n");
+
+    if ( smp_processor_id() != 0 )
+        return xtf_failure("Fail: Boot vCPU has id %u\n", smp_processor_id());
+
+    for ( round = 0; round < ROUNDS; ++round )
+    {
+        printk("Round %u\n", round);
+
+        for ( cpu = 1; cpu < nr; ++cpu )
+        {
+            seen_id[cpu] = ~0u;
+            seen_arg[cpu] = 0;
+        }
+
+        for ( cpu = 1; cpu < nr; ++cpu )
+        {
+            rc = xtf_start_cpu(cpu, record, _p(cpu * 0x100 + round));
+            if ( rc )
+                return xtf_error("Error: Failed to start vCPU %u: %d\n",
+                                 cpu, rc);
+        }
+
+        for ( cpu = 1; cpu < nr; ++cpu )
+        {
+            xtf_wait_cpu(cpu);
+
+            if ( seen_id[cpu] != cpu )
+                xtf_failure("Fail: vCPU %u reported id %u\n",
+                            cpu, seen_id[cpu]);
+
+            if ( seen_arg[cpu] != cpu * 0x100 + round )
+                xtf_failure("Fail: vCPU %u got arg %#lx, expected %#x\n",
+                            cpu, seen_arg[cpu], cpu * 0x100 + round);
+        }
+    }
+
+    if ( xtf_start_cpu(0, record, NULL) != -EINVAL )
+        xtf_failure("Fail: Able to start the boot vCPU\n");
+
+    if ( xtf_start_cpu(nr, record, NULL) != -EINVAL )
+        xtf_failure("Fail: Able to start non-existent vCPU %u\n", nr);
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */